@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gx/allocator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+constexpr size_t ELEMENT_SIZE = 64;
+constexpr size_t BATCH = 16;
+constexpr size_t ITERATIONS = 100000;
+
+/**
+ * Every thread allocates BATCH elements, stamps them and frees them again.
+ * @return Milliseconds taken by all threads
+ */
+template<typename POND>
+double runPond(POND &pond, uint32_t threadCount)
+{
+    std::vector<std::thread> threads;
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (uint32_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&pond, t] {
+            void *elements[BATCH];
+            for (size_t i = 0; i < ITERATIONS; i++) {
+                for (auto &p: elements) {
+                    p = pond.alloc(ELEMENT_SIZE);
+                    memset(p, int(t), ELEMENT_SIZE);
+                }
+                for (auto &p: elements) {
+                    pond.free(p);
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+template<typename POND>
+void benchPond(const char *name, POND &pond)
+{
+    const uint32_t maxThreads = std::clamp(std::thread::hardware_concurrency(), 2u, 8u);
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+        printf("%s, %u threads: %.2f ms\n", name, threads, runPond(pond, threads));
+    }
+}
+
+}
+
+int main()
+{
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::Mutex> mutexPond("BenchMutexPool");
+    benchPond("Mutex", mutexPond);
+
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::SpinLock> spinLockPond("BenchSpinLockPool");
+    benchPond("SpinLock", spinLockPond);
+
+    Pond<AtomicPoolAllocator<ELEMENT_SIZE>, LockingPolicy::NoLock> lockFreePond("BenchLockFreePool");
+    benchPond("Lock-free", lockFreePond);
+
+    // Elements come from the area first, then from heap slabs
+    Pond<AtomicPoolAllocator<ELEMENT_SIZE>, LockingPolicy::NoLock> lockFreeAreaPond("BenchLockFreeAreaPool", 4 * 1024);
+    benchPond("Lock-free with area", lockFreeAreaPond);
+    return 0;
+}
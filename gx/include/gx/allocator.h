@@ -32,7 +32,29 @@
 
 #include <memory.h>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <type_traits>
+#include <algorithm>
+#include <new>
+#include <vector>
+#include <thread>
+
+#if !(GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID)
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define GX_HAS_MEMORY_RESOURCE 1
+#else
+#define GX_HAS_MEMORY_RESOURCE 0
+#endif
 
 
 GX_NS_BEGIN
@@ -69,6 +91,61 @@ static inline P *align(P *p, size_t alignment, size_t offset) noexcept
 
 }
 
+namespace details
+{
+
+/**
+ * @brief Index of the highest set bit, v must not be 0.
+ */
+static inline uint32_t highestBit(size_t v) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+#if defined(_WIN64)
+    _BitScanReverse64(&index, v);
+#else
+    _BitScanReverse(&index, v);
+#endif
+    return (uint32_t) index;
+#else
+    return (uint32_t) (sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(v));
+#endif
+}
+
+/// How long a process attaching to a shared area waits for another one to lay out the header
+constexpr std::chrono::milliseconds SHARED_ATTACH_TIMEOUT{1000};
+
+/**
+ * @brief Wait for the process that initializes a shared header to publish it.
+ * @return false on timeout, the initializing process most likely died half way
+ */
+inline bool waitSharedHeader(const std::atomic<uint32_t> &state, uint32_t ready) noexcept
+{
+    const auto deadline = std::chrono::steady_clock::now() + SHARED_ATTACH_TIMEOUT;
+    while (state.load(std::memory_order_acquire) != ready) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief Size of a virtual memory page.
+ */
+GX_API size_t systemPageSize() noexcept;
+
+/**
+ * @brief Tell the OS that the whole pages inside [begin, end) are no longer needed.
+ * Their physical memory is given back, the range stays valid and is committed again when touched,
+ * its content is undefined afterwards (zeros on Linux).
+ * @return Bytes of the pages given back, 0 when the range holds no whole page
+ */
+GX_API size_t decommitMemory(void *begin, void *end) noexcept;
+
 
 /**
  * @class LinearAllocator
@@ -159,7 +236,7 @@ public:
      */
     void rewind(void *p) noexcept
     {
-        GX_ASSERT(p >= mBegin && p < end());
+        GX_ASSERT(p >= mBegin && p <= end());
         set_current(p);
     }
 
@@ -202,340 +279,2731 @@ private:
     { return pointer::add(mBegin, mCur); }
 
     void set_current(void *p) noexcept
-    { mCur = uint32_t(uintptr_t(p) - uintptr_t(mBegin)); }
+    { mCur = size_t(uintptr_t(p) - uintptr_t(mBegin)); }
 
 private:
     void *mBegin = nullptr;
-    uint32_t mSize = 0;
-    uint32_t mCur = 0;
+    size_t mSize = 0;
+    size_t mCur = 0;
 };
 
 
 /**
- * @class HeapAllocator
- * @brief Standard heap memory allocator.
- *
- * Using alignedAlloc to allocate memory
- * Reclaiming memory using alignedFree
+ * @class ChainedLinearAllocator
+ * @brief Growable LinearAllocator.
+ * The area (if any) is used as the first chunk, when a chunk is full a new one is allocated from the heap
+ * and chained behind it, so the arena does not need to be sized up front.
+ * rewind() and reset() keep the chunks for reuse, trim() releases the unused ones.
  */
-class HeapAllocator
+class ChainedLinearAllocator
 {
 public:
-    HeapAllocator() noexcept = default;
-
-    template<typename AREA>
-    explicit HeapAllocator(const AREA &)
-    {}
-
-    HeapAllocator(const HeapAllocator &rhs) = delete;
-
-    HeapAllocator &operator=(const HeapAllocator &rhs) = delete;
-
-    HeapAllocator(HeapAllocator &&rhs) noexcept = default;
-
-    HeapAllocator &operator=(HeapAllocator &&rhs) noexcept = default;
-
-    ~HeapAllocator() noexcept = default;
-
-public:
-    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0)
-    {
-        // This allocator does not support 'extra'
-        GX_ASSERT(extra == 0);
-        return alignedAlloc(size, alignment);
-    }
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
 
-    void free(void *p) noexcept
+    explicit ChainedLinearAllocator(size_t chunkSize = DEFAULT_CHUNK_SIZE) noexcept
+            : mChunkSize(chunkSize)
     {
-        alignedFree(p);
     }
 
-    void free(void *p, size_t) noexcept
+    /**
+     * @brief Use the provided buffer as the first chunk.
+     * @param begin
+     * @param end
+     * @param chunkSize Size of the chunks allocated when the arena grows
+     */
+    ChainedLinearAllocator(void *begin, void *end, size_t chunkSize = DEFAULT_CHUNK_SIZE) noexcept
+            : mChunkSize(chunkSize)
     {
-        this->free(p);
+        void *const p = pointer::align(begin, alignof(Chunk));
+        if (begin && pointer::add(p, sizeof(Chunk)) < end) {
+            mHead = mCurrent = new(p) Chunk{nullptr, end, false};
+            mCur = mHead->begin();
+        }
     }
 
-    void swap(HeapAllocator &rhs) noexcept
+    template<typename AREA, typename = typename std::enable_if<!std::is_arithmetic<AREA>::value>::type>
+    explicit ChainedLinearAllocator(const AREA &area, size_t chunkSize = DEFAULT_CHUNK_SIZE)
+            : ChainedLinearAllocator(area.begin(), area.end(), chunkSize)
     {}
 
-    size_t size() const noexcept
-    {
-        return 0;
-    }
-
-    size_t capacity() const noexcept
-    {
-        return 0;
-    }
-};
-
-// ------------------------------------------------------------------------------------------------
+    ChainedLinearAllocator(const ChainedLinearAllocator &rhs) = delete;
 
-class FreeList
-{
-public:
-    FreeList() noexcept = delete;
+    ChainedLinearAllocator &operator=(const ChainedLinearAllocator &rhs) = delete;
 
-    FreeList(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
-            : mElementSize(elementSize),
-              mAlignment(alignment),
-              mHead(init(begin, end, elementSize, alignment, extra)),
-              mUserBegin(begin),
-              mUserEnd(end)
+    ChainedLinearAllocator(ChainedLinearAllocator &&rhs) noexcept
     {
+        this->swap(rhs);
     }
 
-    FreeList(size_t elementSize, size_t alignment) noexcept
-            : mElementSize(elementSize),
-              mAlignment(alignment)
+    ChainedLinearAllocator &operator=(ChainedLinearAllocator &&rhs) noexcept
     {
+        if (this != &rhs) {
+            this->swap(rhs);
+        }
+        return *this;
     }
 
-    FreeList(const FreeList &rhs) = delete;
-
-    ~FreeList()
+    ~ChainedLinearAllocator() noexcept
     {
-        clear();
+        Chunk *chunk = mHead;
+        while (chunk) {
+            Chunk *next = chunk->next;
+            if (chunk->owned) {
+                alignedFree(chunk);
+            }
+            chunk = next;
+        }
     }
 
-    FreeList &operator=(const FreeList &rhs) = delete;
-
-    FreeList(FreeList &&rhs) noexcept = default;
-
-    FreeList &operator=(FreeList &&rhs) noexcept = default;
-
 public:
-    void *pop() noexcept
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0)
     {
-        if (mHead == nullptr) {
-            Node *const head = createNode();
-            GX_ASSERT(head);
-            if (head == nullptr) {
-                return nullptr;
+        if (mCurrent) {
+            void *const p = pointer::align(mCur, alignment, extra);
+            void *const c = pointer::add(p, size);
+            if (c <= mCurrent->end) {
+                mCur = c;
+                return p;
             }
-            head->next = nullptr;
-            mHead = head;
         }
-        Node *const head = mHead;
-        mHead = (head ? head->next : nullptr);
-        ++mAllocCount;
-        return head;
+        return allocSlow(size, alignment, extra);
     }
 
-    void push(void *p) noexcept
+    /**
+     * @brief Get current header pointer, can be passed to rewind().
+     * @return
+     */
+    void *getCurrent() noexcept
+    {
+        return mCur;
+    }
+
+    /**
+     * @brief Fallback memory pointer to a specific point returned by getCurrent().
+     * This is O(1) when the point is in the current chunk, otherwise the chunks in use are searched.
+     *
+     * @param p
+     */
+    void rewind(void *p) noexcept
     {
-        GX_ASSERT(p);
         if (p == nullptr) {
+            reset();
             return;
         }
-        Node *const head = static_cast<Node *>(p);
-        head->next = mHead;
-        mHead = head;
-        --mAllocCount;
+        if (mCurrent && p >= mCurrent->begin() && p <= mCurrent->end) {
+            mCur = p;
+            return;
+        }
+        for (Chunk *chunk = mHead; chunk && chunk != mCurrent; chunk = chunk->next) {
+            if (p >= chunk->begin() && p <= chunk->end) {
+                mCurrent = chunk;
+                mCur = p;
+                return;
+            }
+        }
+        GX_ASSERT_S(false, "ChainedLinearAllocator::rewind: pointer does not belong to this arena");
     }
 
-    void *getFirst() noexcept
+    /**
+     * @brief Roll back memory pointer to the beginning, chunks are kept for reuse.
+     */
+    void reset() noexcept
     {
-        return mHead;
+        mCurrent = mHead;
+        mCur = mHead ? mHead->begin() : nullptr;
     }
 
-    void clear() noexcept
+    /**
+     * @brief Release the chunks after the current one.
+     */
+    void trim() noexcept
     {
-        Node *userNodeHead = nullptr;
-        while (mHead) {
-            Node *next = mHead->next;
-            if (mHead >= mUserBegin && mHead < mUserEnd) {
-                mHead->next = userNodeHead;
-                userNodeHead = mHead;
-            } else {
-                alignedFree(mHead);
-            }
-            mHead = next;
+        if (!mCurrent) {
+            return;
+        }
+        Chunk *chunk = mCurrent->next;
+        mCurrent->next = nullptr;
+        while (chunk) {
+            Chunk *next = chunk->next;
+            GX_ASSERT(chunk->owned);
+            alignedFree(chunk);
+            chunk = next;
         }
-        mHead = userNodeHead;
     }
 
     size_t size() const noexcept
     {
-        return mAllocCount * mElementSize;
+        size_t size = 0;
+        for (Chunk *chunk = mHead; chunk && chunk != mCurrent; chunk = chunk->next) {
+            size += chunk->size();
+        }
+        if (mCurrent) {
+            size += uintptr_t(mCur) - uintptr_t(mCurrent->begin());
+        }
+        return size;
     }
 
     size_t capacity() const noexcept
     {
-        size_t count = 0;
-        for (Node *c = mHead; c != nullptr; c = c->next) {
-            ++count;
+        size_t capacity = 0;
+        for (Chunk *chunk = mHead; chunk; chunk = chunk->next) {
+            capacity += chunk->size();
         }
-        return count * mElementSize + size();
+        return capacity;
     }
 
-private:
-    struct Node
+    void swap(ChainedLinearAllocator &rhs) noexcept
     {
-        Node *next;
-    };
+        std::swap(mHead, rhs.mHead);
+        std::swap(mCurrent, rhs.mCurrent);
+        std::swap(mCur, rhs.mCur);
+        std::swap(mChunkSize, rhs.mChunkSize);
+    }
+
+    void free(void *) noexcept
+    {}
 
-    static Node *init(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    void free(void *, size_t) noexcept
+    {}
+
+private:
+    struct alignas(std::max_align_t) Chunk
     {
-        void *const p = pointer::align(begin, alignment, extra);
-        void *const n = pointer::align(pointer::add(p, elementSize), alignment, extra);
-        GX_ASSERT(p >= begin && p < end);
-        GX_ASSERT(n >= begin && n < end && n > p);
+        Chunk *next;
+        void *end;
+        bool owned;
 
-        const size_t d = uintptr_t(n) - uintptr_t(p);
-        const size_t num = (uintptr_t(end) - uintptr_t(p)) / d;
+        void *begin() const noexcept
+        { return const_cast<Chunk *>(this + 1); }
 
-        Node *head = static_cast<Node *>(p);
+        size_t size() const noexcept
+        { return uintptr_t(end) - uintptr_t(begin()); }
+    };
 
-        Node *cur = head;
-        for (size_t i = 1; i < num; ++i) {
-            Node *next = pointer::add(cur, d);
-            cur->next = next;
-            cur = next;
+    void *allocSlow(size_t size, size_t alignment, size_t extra)
+    {
+        // Reuse the chunks kept by rewind() / reset() first
+        for (Chunk *chunk = mCurrent ? mCurrent->next : mHead; chunk; chunk = chunk->next) {
+            void *const p = pointer::align(chunk->begin(), alignment, extra);
+            void *const c = pointer::add(p, size);
+            if (c <= chunk->end) {
+                mCurrent = chunk;
+                mCur = c;
+                return p;
+            }
         }
-        GX_ASSERT(cur < end);
-        GX_ASSERT(pointer::add(cur, d) <= end);
-        cur->next = nullptr;
-        return head;
-    }
 
-    Node *createNode() const noexcept
-    {
-        return static_cast<Node *>(alignedAlloc(mElementSize, mAlignment));
+        const size_t chunkSize = std::max(mChunkSize, sizeof(Chunk) + alignment + extra + size);
+        void *const mem = alignedAlloc(chunkSize, alignof(Chunk));
+        if (!mem) {
+            return nullptr;
+        }
+        Chunk *const chunk = new(mem) Chunk{nullptr, pointer::add(mem, chunkSize), true};
+        if (mCurrent) {
+            chunk->next = mCurrent->next;
+            mCurrent->next = chunk;
+        } else {
+            mHead = chunk;
+        }
+        mCurrent = chunk;
+
+        void *const p = pointer::align(chunk->begin(), alignment, extra);
+        mCur = pointer::add(p, size);
+        return p;
     }
 
 private:
-    size_t mElementSize = 0;
-    size_t mAlignment = 0;
-    Node *mHead = nullptr;
-    void *mUserBegin = nullptr;
-    void *mUserEnd = nullptr;
-    size_t mAllocCount = 0;
+    Chunk *mHead = nullptr;
+    Chunk *mCurrent = nullptr;
+    void *mCur = nullptr;
+    size_t mChunkSize = DEFAULT_CHUNK_SIZE;
 };
 
-// ------------------------------------------------------------------------------------------------
 
 /**
- * @class PoolAllocator
- *
- * For memory pool allocation of fixed large and small blocks,
- * Only memory within a fixed size can be allocated at a time,
- * A certain size of continuous memory can be pre allocated as the initial memory block of the pool,
- * The default FreeList will allocate more memory after the original memory block is exhausted,
- * These memory that has not been allocated can be reclaimed using reset, and will also be reclaimed during PoolAllocator deconstruction,
- * Before disassembling PoolAllocator, it is important to free all allocated memory blocks, otherwise it will cause memory leakage
- *
- * @tparam ELEMENT_SIZE Element size (byte) must be greater than or equal to sizeof (void *)
- * @tparam ALIGNMENT    Alignment during element memory allocation
- * @tparam OFFSET       Offset for element memory alignment
+ * @class SharedLinearAllocator
+ * @brief LinearAllocator whose cursor lives at the start of its area, for SharedMemoryArea.
+ * The cursor is an offset advanced atomically, so processes that map the area at different addresses
+ * (and threads) allocate from one arena without a lock.
+ * The first process to attach initializes the header, the area must be zero-filled at that time.
+ * If that process dies half way, the others give up after details::SHARED_ATTACH_TIMEOUT
+ * and stay detached (alloc() returns nullptr).
+ * rewind() and reset() move the cursor for every process.
  */
-template<size_t ELEMENT_SIZE,
-        size_t ALIGNMENT = alignof(std::max_align_t),
-        size_t OFFSET = 0>
-class PoolAllocator
+class SharedLinearAllocator
 {
-private:
-    /// At least one Node pointer size must be accommodated
-    static_assert(ELEMENT_SIZE >= sizeof(void *), "ELEMENT_SIZE must accommodate at least a pointer");
-
 public:
-    PoolAllocator() noexcept
-            : mFreeList(ELEMENT_SIZE, ALIGNMENT)
-    {
-    }
+    SharedLinearAllocator() noexcept = default;
 
-    PoolAllocator(void *begin, void *end) noexcept
-            : mFreeList(begin, end, ELEMENT_SIZE, ALIGNMENT, OFFSET)
+    SharedLinearAllocator(void *begin, void *end) noexcept
     {
+        attach(begin, end);
     }
 
     template<typename AREA>
-    explicit PoolAllocator(const AREA &area) noexcept
-            : PoolAllocator(area.begin(), area.end())
-    {
-    }
+    explicit SharedLinearAllocator(const AREA &area) noexcept
+            : SharedLinearAllocator(area.begin(), area.end())
+    {}
 
-    PoolAllocator(const PoolAllocator &rhs) = delete;
+    SharedLinearAllocator(const SharedLinearAllocator &rhs) = delete;
 
-    PoolAllocator &operator=(const PoolAllocator &rhs) = delete;
+    SharedLinearAllocator &operator=(const SharedLinearAllocator &rhs) = delete;
 
-    PoolAllocator(PoolAllocator &&rhs) noexcept = default;
+    SharedLinearAllocator(SharedLinearAllocator &&rhs) noexcept
+    {
+        this->swap(rhs);
+    }
 
-    PoolAllocator &operator=(PoolAllocator &&rhs) noexcept = default;
+    SharedLinearAllocator &operator=(SharedLinearAllocator &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            this->swap(rhs);
+        }
+        return *this;
+    }
 
-    ~PoolAllocator() noexcept = default;
+    ~SharedLinearAllocator() noexcept = default;
 
 public:
-    void *alloc(size_t size = ELEMENT_SIZE,
-                size_t alignment = ALIGNMENT, size_t offset = OFFSET) noexcept
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0) noexcept
     {
-        GX_ASSERT(size <= ELEMENT_SIZE);
-        GX_ASSERT(alignment <= ALIGNMENT);
-        GX_ASSERT(offset == OFFSET);
-        return mFreeList.pop();
+        if (mHeader == nullptr) {
+            return nullptr;
+        }
+        uint64_t cur = mHeader->cursor.load(std::memory_order_relaxed);
+        for (;;) {
+            // Alignment is computed on the offset, the area start is page aligned in every process
+            const uint64_t p = pointer::alignSize(cur + extra, alignment) - extra;
+            const uint64_t c = p + size;
+            if (c > mHeader->capacity || c < p) {
+                return nullptr;
+            }
+            if (mHeader->cursor.compare_exchange_weak(cur, c, std::memory_order_relaxed)) {
+                return pointer::add(mHeader, p);
+            }
+        }
     }
 
-    void free(void *p, size_t = ELEMENT_SIZE) noexcept
+    void *getCurrent() noexcept
     {
-        mFreeList.push(p);
+        return mHeader ? pointer::add(mHeader, mHeader->cursor.load(std::memory_order_relaxed)) : nullptr;
+    }
+
+    void rewind(void *p) noexcept
+    {
+        if (mHeader) {
+            GX_ASSERT(p >= pointer::add(mHeader, sizeof(Header)) && p <= pointer::add(mHeader, mHeader->capacity));
+            mHeader->cursor.store(uintptr_t(p) - uintptr_t(mHeader), std::memory_order_relaxed);
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (mHeader) {
+            mHeader->cursor.store(sizeof(Header), std::memory_order_relaxed);
+        }
     }
 
     size_t size() const noexcept
     {
-        return mFreeList.size();
+        return mHeader ? size_t(mHeader->cursor.load(std::memory_order_relaxed) - sizeof(Header)) : 0;
     }
 
     size_t capacity() const noexcept
     {
-        return mFreeList.capacity();
+        return mHeader ? size_t(mHeader->capacity - sizeof(Header)) : 0;
     }
 
-    void *getCurrent() noexcept
+    /**
+     * @brief Position of an allocation in the area, valid in every process.
+     */
+    uint64_t offsetOf(const void *p) const noexcept
     {
-        return mFreeList.getFirst();
+        return uintptr_t(p) - uintptr_t(mHeader);
     }
 
-    void reset() noexcept
+    void *at(uint64_t offset) const noexcept
     {
-        mFreeList.clear();
+        return pointer::add(mHeader, offset);
+    }
+
+    void swap(SharedLinearAllocator &rhs) noexcept
+    {
+        std::swap(mHeader, rhs.mHeader);
+    }
+
+    void free(void *) noexcept
+    {}
+
+    void free(void *, size_t) noexcept
+    {}
+
+private:
+    constexpr static uint32_t MAGIC = 0x47584c41; // "GXLA"
+
+    struct Header
+    {
+        std::atomic<uint32_t> state;
+        uint32_t magic;
+        uint64_t capacity;
+        /// Offset of the first free byte, from the area start
+        std::atomic<uint64_t> cursor;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                  "SharedLinearAllocator needs address-free atomics");
+
+    void attach(void *begin, void *end) noexcept
+    {
+        if (begin == nullptr || pointer::add(begin, sizeof(Header)) > end) {
+            return;
+        }
+        GX_ASSERT_S(uintptr_t(begin) % alignof(Header) == 0, "SharedLinearAllocator: misaligned area");
+        Header *const header = static_cast<Header *>(begin);
+
+        // 0: zero-filled, 1: initializing, 2: ready
+        uint32_t state = 0;
+        if (header->state.compare_exchange_strong(state, 1, std::memory_order_acquire)) {
+            header->magic = MAGIC;
+            header->capacity = uintptr_t(end) - uintptr_t(begin);
+            header->cursor.store(sizeof(Header), std::memory_order_relaxed);
+            header->state.store(2, std::memory_order_release);
+        } else if (!details::waitSharedHeader(header->state, 2)) {
+            GX_ASSERT_S(false, "SharedLinearAllocator: the area was never initialized, recreate it");
+            return;
+        }
+        GX_ASSERT_S(header->magic == MAGIC, "SharedLinearAllocator: the area holds a different allocator");
+        if (header->magic == MAGIC) {
+            mHeader = header;
+        }
+    }
+
+private:
+    Header *mHeader = nullptr;
+};
+
+/**
+ * @class ScopedArenaMarker
+ * @brief Save the current position of a linear arena (LinearAllocator, ChainedLinearAllocator,
+ * or a Pond of them) and rewind to it when leaving the scope.
+ * @tparam ARENA
+ */
+template<typename ARENA>
+class ScopedArenaMarker
+{
+public:
+    explicit ScopedArenaMarker(ARENA &arena) noexcept
+            : mArena(arena), mMarker(arena.getCurrent())
+    {
+    }
+
+    ~ScopedArenaMarker() noexcept
+    {
+        mArena.rewind(mMarker);
+    }
+
+    ScopedArenaMarker(const ScopedArenaMarker &rhs) = delete;
+
+    ScopedArenaMarker &operator=(const ScopedArenaMarker &rhs) = delete;
+
+private:
+    ARENA &mArena;
+    void *mMarker;
+};
+
+
+/**
+ * @class ScratchArena
+ * @brief Thread local ChainedLinearAllocator for short-lived temporaries.
+ * Allocations are released together when the enclosing ScratchScope exits, the chunks are kept,
+ * so the temporaries of repeated calls cost no heap allocation once the arena has grown.
+ * Scopes nest, memory from an inner scope must not be used after it exits.
+ */
+class GX_API ScratchArena
+{
+public:
+    constexpr static size_t CHUNK_SIZE = 64 * 1024;
+
+    /**
+     * @brief Arena of the calling thread.
+     */
+    static ChainedLinearAllocator &local() noexcept;
+
+    /**
+     * @return nullptr when out of memory
+     */
+    static void *alloc(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        return local().alloc(size, alignment);
+    }
+
+    template<typename T,
+            typename = typename std::enable_if<std::is_trivially_destructible<T>::value>::type>
+    static T *alloc(size_t count)
+    {
+        return (T *) alloc(count * sizeof(T), alignof(T));
+    }
+
+    /**
+     * @brief Release the chunks of the calling thread that are not in use.
+     */
+    static void trim() noexcept
+    {
+        local().trim();
+    }
+};
+
+/**
+ * @class ScratchScope
+ * @brief Rewind the calling thread's ScratchArena when leaving the scope.
+ */
+class ScratchScope : public ScopedArenaMarker<ChainedLinearAllocator>
+{
+public:
+    ScratchScope() noexcept
+            : ScopedArenaMarker<ChainedLinearAllocator>(ScratchArena::local())
+    {
+    }
+};
+
+
+/**
+ * @class StackAllocator
+ * @brief Variable size allocations freed in LIFO order.
+ * Each allocation stores a small header before the returned block, freeing the top block moves
+ * the allocation pointer back. A block freed out of order is only marked, its space is reclaimed
+ * once the blocks above it are freed.
+ */
+class StackAllocator
+{
+public:
+    StackAllocator() = default;
+
+    /**
+     * @brief Use the provided buffer.
+     * @param begin
+     * @param end
+     */
+    StackAllocator(void *begin, void *end) noexcept
+            : mBegin(begin), mEnd(end), mCur(begin)
+    {
+    }
+
+    template<typename AREA>
+    explicit StackAllocator(const AREA &area)
+            : StackAllocator(area.begin(), area.end())
+    {}
+
+    StackAllocator(const StackAllocator &rhs) = delete;
+
+    StackAllocator &operator=(const StackAllocator &rhs) = delete;
+
+    StackAllocator(StackAllocator &&rhs) noexcept
+    {
+        this->swap(rhs);
+    }
+
+    StackAllocator &operator=(StackAllocator &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            this->swap(rhs);
+        }
+        return *this;
+    }
+
+    ~StackAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0)
+    {
+        void *const p = pointer::align(mCur, std::max(alignment, alignof(Header)), extra + sizeof(Header));
+        void *const c = pointer::add(p, size);
+        if (c > mEnd) {
+            return nullptr;
+        }
+        Header *const header = static_cast<Header *>(p) - 1;
+        header->prevCur = mCur;
+        header->prevTop = mTop;
+        header->freed = false;
+        mCur = c;
+        mTop = p;
+        return p;
+    }
+
+    void free(void *p) noexcept
+    {
+        if (p == nullptr) {
+            return;
+        }
+        GX_ASSERT(p >= mBegin && p < mCur);
+        header(p)->freed = true;
+        while (mTop && header(mTop)->freed) {
+            Header *const top = header(mTop);
+            mCur = top->prevCur;
+            mTop = top->prevTop;
+        }
+    }
+
+    void free(void *p, size_t) noexcept
+    {
+        this->free(p);
+    }
+
+    /**
+     * @brief Release all blocks at once.
+     */
+    void reset() noexcept
+    {
+        mCur = mBegin;
+        mTop = nullptr;
+    }
+
+    size_t size() const noexcept
+    {
+        return uintptr_t(mCur) - uintptr_t(mBegin);
+    }
+
+    size_t capacity() const noexcept
+    {
+        return uintptr_t(mEnd) - uintptr_t(mBegin);
+    }
+
+    void swap(StackAllocator &rhs) noexcept
+    {
+        std::swap(mBegin, rhs.mBegin);
+        std::swap(mEnd, rhs.mEnd);
+        std::swap(mCur, rhs.mCur);
+        std::swap(mTop, rhs.mTop);
+    }
+
+private:
+    struct Header
+    {
+        void *prevCur;
+        void *prevTop;
+        bool freed;
+    };
+
+    static Header *header(void *p) noexcept
+    { return static_cast<Header *>(p) - 1; }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+    void *mCur = nullptr;
+    void *mTop = nullptr;
+};
+
+
+/**
+ * @class HeapAllocator
+ * @brief Standard heap memory allocator.
+ *
+ * Using alignedAlloc to allocate memory
+ * Reclaiming memory using alignedFree
+ */
+class HeapAllocator
+{
+public:
+    HeapAllocator() noexcept = default;
+
+    template<typename AREA>
+    explicit HeapAllocator(const AREA &)
+    {}
+
+    HeapAllocator(const HeapAllocator &rhs) = delete;
+
+    HeapAllocator &operator=(const HeapAllocator &rhs) = delete;
+
+    HeapAllocator(HeapAllocator &&rhs) noexcept = default;
+
+    HeapAllocator &operator=(HeapAllocator &&rhs) noexcept = default;
+
+    ~HeapAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0)
+    {
+        // This allocator does not support 'extra'
+        GX_ASSERT(extra == 0);
+        return alignedAlloc(size, alignment);
+    }
+
+    void free(void *p) noexcept
+    {
+        alignedFree(p);
+    }
+
+    void free(void *p, size_t) noexcept
+    {
+        this->free(p);
+    }
+
+    void swap(HeapAllocator &rhs) noexcept
+    {}
+
+    size_t size() const noexcept
+    {
+        return 0;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return 0;
+    }
+};
+
+/**
+ * @class TlsfAllocator
+ * @brief Two-Level Segregated Fit allocator for variable size blocks inside an area.
+ * Free blocks are kept in lists segregated by size: the first level splits by power of two,
+ * the second level splits each power of two into 32 ranges, two bitmaps find a fitting list with
+ * bit scans, so alloc() and free() are O(1) and the wasted space per request is bounded (about 1/32).
+ * Neighbouring free blocks are merged on free().
+ * Each block has a two pointer header, payloads are aligned to 2 * sizeof(void *),
+ * larger alignments split a leading gap off the chosen block.
+ * The area can be up to 4G (1G on 32 bit systems).
+ */
+class TlsfAllocator
+{
+public:
+    TlsfAllocator() noexcept = default;
+
+    TlsfAllocator(void *begin, void *end) noexcept
+            : mBegin(begin), mEnd(end)
+    {
+        init();
+    }
+
+    template<typename AREA>
+    explicit TlsfAllocator(const AREA &area) noexcept
+            : TlsfAllocator(area.begin(), area.end())
+    {}
+
+    TlsfAllocator(const TlsfAllocator &rhs) = delete;
+
+    TlsfAllocator &operator=(const TlsfAllocator &rhs) = delete;
+
+    TlsfAllocator(TlsfAllocator &&rhs) noexcept
+    {
+        this->swap(rhs);
+    }
+
+    TlsfAllocator &operator=(TlsfAllocator &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            this->swap(rhs);
+        }
+        return *this;
+    }
+
+    ~TlsfAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0) noexcept
+    {
+        // This allocator does not support 'extra'
+        GX_ASSERT(extra == 0);
+        GX_ASSERT(alignment && !(alignment & (alignment - 1)));
+
+        const size_t adjust = adjustRequestSize(size);
+        if (adjust == 0) {
+            return nullptr;
+        }
+        if (alignment <= ALIGN_SIZE) {
+            return prepareUsed(locateFree(adjust), adjust);
+        }
+
+        // Room for the alignment and for a leading gap big enough to be a free block
+        const size_t gapMinimum = BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN;
+        const size_t sizeWithGap = adjustRequestSize(adjust + alignment + gapMinimum);
+        if (sizeWithGap == 0) {
+            return nullptr;
+        }
+        Block *block = locateFree(sizeWithGap);
+        if (block) {
+            void *const p = payload(block);
+            void *aligned = pointer::align(p, alignment);
+            size_t gap = uintptr_t(aligned) - uintptr_t(p);
+            if (gap && gap < gapMinimum) {
+                const size_t offset = std::max(gapMinimum - gap, alignment);
+                aligned = pointer::align(pointer::add(aligned, offset), alignment);
+                gap = uintptr_t(aligned) - uintptr_t(p);
+            }
+            if (gap) {
+                block = trimFreeLeading(block, gap);
+            }
+        }
+        return prepareUsed(block, adjust);
+    }
+
+    void free(void *p) noexcept
+    {
+        if (p == nullptr) {
+            return;
+        }
+        Block *block = fromPayload(p);
+        GX_ASSERT_S(!block->isFree(), "TlsfAllocator::free: block is already free");
+        mUsedSize -= block->size();
+        markAsFree(block);
+        block = mergePrev(block);
+        block = mergeNext(block);
+        insertBlock(block);
+    }
+
+    void free(void *p, size_t) noexcept
+    {
+        this->free(p);
+    }
+
+    /**
+     * @brief Free every block at once.
+     */
+    void reset() noexcept
+    {
+        if (mBegin) {
+            init();
+        }
+    }
+
+    /**
+     * @brief Usable size of an allocated block, at least the requested size.
+     */
+    static size_t blockSize(const void *p) noexcept
+    {
+        return p ? fromPayload(const_cast<void *>(p))->size() : 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return mUsedSize;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return mCapacity;
+    }
+
+    void swap(TlsfAllocator &rhs) noexcept
+    {
+        using std::swap;
+        swap(mBegin, rhs.mBegin);
+        swap(mEnd, rhs.mEnd);
+        swap(mFlBitmap, rhs.mFlBitmap);
+        swap(mSlBitmap, rhs.mSlBitmap);
+        swap(mBlocks, rhs.mBlocks);
+        swap(mUsedSize, rhs.mUsedSize);
+        swap(mCapacity, rhs.mCapacity);
+    }
+
+private:
+    constexpr static size_t ALIGN_SIZE = 2 * sizeof(void *);
+    constexpr static uint32_t ALIGN_SIZE_LOG2 = sizeof(void *) == 8 ? 4 : 3;
+    constexpr static uint32_t SL_INDEX_COUNT_LOG2 = 5;
+    constexpr static uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+    constexpr static uint32_t FL_INDEX_MAX = sizeof(void *) == 8 ? 32 : 30;
+    constexpr static uint32_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+    constexpr static uint32_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+    constexpr static size_t SMALL_BLOCK_SIZE = size_t(1) << FL_INDEX_SHIFT;
+    constexpr static size_t BLOCK_SIZE_MAX = size_t(1) << FL_INDEX_MAX;
+
+    static_assert(ALIGN_SIZE == (size_t(1) << ALIGN_SIZE_LOG2), "TlsfAllocator: ALIGN_SIZE mismatch");
+
+    constexpr static size_t FREE_BIT = 1;
+    constexpr static size_t PREV_FREE_BIT = 2;
+
+    /**
+     * Header of every block, the payload follows it.
+     * The free list links live in the payload, they are only valid while the block is free.
+     */
+    struct Block
+    {
+        Block *prevPhysical;
+        size_t sizeAndFlags;
+        Block *nextFree;
+        Block *prevFree;
+
+        size_t size() const noexcept
+        { return sizeAndFlags & ~(FREE_BIT | PREV_FREE_BIT); }
+
+        void setSize(size_t size) noexcept
+        { sizeAndFlags = size | (sizeAndFlags & (FREE_BIT | PREV_FREE_BIT)); }
+
+        bool isFree() const noexcept
+        { return sizeAndFlags & FREE_BIT; }
+
+        void setFree(bool free) noexcept
+        { sizeAndFlags = free ? sizeAndFlags | FREE_BIT : sizeAndFlags & ~FREE_BIT; }
+
+        bool isPrevFree() const noexcept
+        { return sizeAndFlags & PREV_FREE_BIT; }
+
+        void setPrevFree(bool free) noexcept
+        { sizeAndFlags = free ? sizeAndFlags | PREV_FREE_BIT : sizeAndFlags & ~PREV_FREE_BIT; }
+    };
+
+    constexpr static size_t BLOCK_HEADER_SIZE = 2 * sizeof(void *);
+    constexpr static size_t BLOCK_SIZE_MIN = sizeof(Block) - BLOCK_HEADER_SIZE;
+
+    static_assert(BLOCK_HEADER_SIZE % ALIGN_SIZE == 0 && BLOCK_SIZE_MIN % ALIGN_SIZE == 0,
+                  "TlsfAllocator: block layout must keep payloads aligned");
+
+    static uint32_t lowestBit(uint32_t v) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, v);
+        return (uint32_t) index;
+#else
+        return (uint32_t) __builtin_ctz(v);
+#endif
+    }
+
+    static void *payload(Block *block) noexcept
+    {
+        return pointer::add(block, BLOCK_HEADER_SIZE);
+    }
+
+    static Block *fromPayload(void *p) noexcept
+    {
+        return (Block *) (uintptr_t(p) - BLOCK_HEADER_SIZE);
+    }
+
+    static Block *nextPhysical(Block *block) noexcept
+    {
+        return (Block *) pointer::add(payload(block), block->size());
+    }
+
+    static Block *linkNext(Block *block) noexcept
+    {
+        Block *const next = nextPhysical(block);
+        next->prevPhysical = block;
+        return next;
+    }
+
+    static size_t adjustRequestSize(size_t size) noexcept
+    {
+        if (size >= BLOCK_SIZE_MAX) {
+            return 0;
+        }
+        return std::max(pointer::alignSize(size, ALIGN_SIZE), BLOCK_SIZE_MIN);
+    }
+
+    static void mappingInsert(size_t size, uint32_t &fl, uint32_t &sl) noexcept
+    {
+        if (size < SMALL_BLOCK_SIZE) {
+            fl = 0;
+            sl = uint32_t(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+        } else {
+            const uint32_t bit = details::highestBit(size);
+            sl = uint32_t(size >> (bit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+            fl = bit - (FL_INDEX_SHIFT - 1);
+        }
+    }
+
+    /// Round up to the next list so that any block found there is large enough
+    static void mappingSearch(size_t size, uint32_t &fl, uint32_t &sl) noexcept
+    {
+        if (size >= SMALL_BLOCK_SIZE) {
+            size += (size_t(1) << (details::highestBit(size) - SL_INDEX_COUNT_LOG2)) - 1;
+        }
+        mappingInsert(size, fl, sl);
+    }
+
+    Block *searchSuitableBlock(uint32_t &fl, uint32_t &sl) noexcept
+    {
+        uint32_t slMap = mSlBitmap[fl] & (~0u << sl);
+        if (!slMap) {
+            const uint32_t flMap = mFlBitmap & (~0u << (fl + 1));
+            if (!flMap) {
+                return nullptr;
+            }
+            fl = lowestBit(flMap);
+            slMap = mSlBitmap[fl];
+        }
+        sl = lowestBit(slMap);
+        return mBlocks[fl][sl];
+    }
+
+    void insertBlock(Block *block) noexcept
+    {
+        uint32_t fl, sl;
+        mappingInsert(block->size(), fl, sl);
+        Block *const current = mBlocks[fl][sl];
+        block->nextFree = current;
+        block->prevFree = nullptr;
+        if (current) {
+            current->prevFree = block;
+        }
+        mBlocks[fl][sl] = block;
+        mFlBitmap |= 1u << fl;
+        mSlBitmap[fl] |= 1u << sl;
+    }
+
+    void removeBlock(Block *block, uint32_t fl, uint32_t sl) noexcept
+    {
+        Block *const prev = block->prevFree;
+        Block *const next = block->nextFree;
+        if (next) {
+            next->prevFree = prev;
+        }
+        if (prev) {
+            prev->nextFree = next;
+        } else {
+            mBlocks[fl][sl] = next;
+            if (next == nullptr) {
+                mSlBitmap[fl] &= ~(1u << sl);
+                if (!mSlBitmap[fl]) {
+                    mFlBitmap &= ~(1u << fl);
+                }
+            }
+        }
+    }
+
+    void removeBlock(Block *block) noexcept
+    {
+        uint32_t fl, sl;
+        mappingInsert(block->size(), fl, sl);
+        removeBlock(block, fl, sl);
+    }
+
+    static bool canSplit(Block *block, size_t size) noexcept
+    {
+        return block->size() >= size + BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN;
+    }
+
+    /// Split off the tail of block past size as a new free block
+    static Block *split(Block *block, size_t size) noexcept
+    {
+        Block *const remaining = (Block *) pointer::add(payload(block), size);
+        remaining->sizeAndFlags = block->size() - size - BLOCK_HEADER_SIZE;
+        markAsFree(remaining);
+        block->setSize(size);
+        return remaining;
+    }
+
+    static Block *absorb(Block *prev, Block *block) noexcept
+    {
+        prev->setSize(prev->size() + block->size() + BLOCK_HEADER_SIZE);
+        linkNext(prev);
+        return prev;
+    }
+
+    static void markAsFree(Block *block) noexcept
+    {
+        linkNext(block)->setPrevFree(true);
+        block->setFree(true);
+    }
+
+    static void markAsUsed(Block *block) noexcept
+    {
+        nextPhysical(block)->setPrevFree(false);
+        block->setFree(false);
+    }
+
+    Block *mergePrev(Block *block) noexcept
+    {
+        if (block->isPrevFree()) {
+            Block *const prev = block->prevPhysical;
+            removeBlock(prev);
+            block = absorb(prev, block);
+        }
+        return block;
+    }
+
+    Block *mergeNext(Block *block) noexcept
+    {
+        Block *const next = nextPhysical(block);
+        if (next->isFree()) {
+            removeBlock(next);
+            block = absorb(block, next);
+        }
+        return block;
+    }
+
+    /// Give the tail of a block that is about to be used back to the free lists
+    void trimFree(Block *block, size_t size) noexcept
+    {
+        if (canSplit(block, size)) {
+            Block *const remaining = split(block, size);
+            linkNext(block);
+            remaining->setPrevFree(true);
+            insertBlock(remaining);
+        }
+    }
+
+    /// Free the leading gap of a block, returns the block that starts after it
+    Block *trimFreeLeading(Block *block, size_t gap) noexcept
+    {
+        Block *remaining = block;
+        if (canSplit(block, gap - BLOCK_HEADER_SIZE)) {
+            remaining = split(block, gap - BLOCK_HEADER_SIZE);
+            remaining->setPrevFree(true);
+            linkNext(block);
+            insertBlock(block);
+        }
+        return remaining;
+    }
+
+    Block *locateFree(size_t size) noexcept
+    {
+        uint32_t fl, sl;
+        mappingSearch(size, fl, sl);
+        if (fl >= FL_INDEX_COUNT) {
+            return nullptr;
+        }
+        Block *const block = searchSuitableBlock(fl, sl);
+        if (block) {
+            GX_ASSERT(block->size() >= size);
+            removeBlock(block, fl, sl);
+        }
+        return block;
+    }
+
+    void *prepareUsed(Block *block, size_t size) noexcept
+    {
+        if (block == nullptr) {
+            return nullptr;
+        }
+        trimFree(block, size);
+        markAsUsed(block);
+        mUsedSize += block->size();
+        return payload(block);
+    }
+
+    void init() noexcept
+    {
+        mFlBitmap = 0;
+        memset(mSlBitmap, 0, sizeof(mSlBitmap));
+        memset(mBlocks, 0, sizeof(mBlocks));
+        mUsedSize = 0;
+        mCapacity = 0;
+
+        // One free block over the whole area, followed by a zero sized used block that stops merging
+        void *const first = pointer::align(pointer::add(mBegin, BLOCK_HEADER_SIZE), ALIGN_SIZE);
+        if (uintptr_t(first) + BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN > uintptr_t(mEnd)) {
+            return;
+        }
+        size_t size = (uintptr_t(mEnd) - uintptr_t(first) - BLOCK_HEADER_SIZE) & ~(ALIGN_SIZE - 1);
+        size = std::min(size, BLOCK_SIZE_MAX - ALIGN_SIZE);
+        if (size < BLOCK_SIZE_MIN) {
+            return;
+        }
+        Block *const block = fromPayload(first);
+        block->sizeAndFlags = size;
+        block->setFree(true);
+        block->setPrevFree(false);
+        insertBlock(block);
+
+        Block *const sentinel = linkNext(block);
+        sentinel->sizeAndFlags = 0;
+        sentinel->setFree(false);
+        sentinel->setPrevFree(true);
+        mCapacity = size;
+    }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+    uint32_t mFlBitmap = 0;
+    uint32_t mSlBitmap[FL_INDEX_COUNT] = {};
+    Block *mBlocks[FL_INDEX_COUNT][SL_INDEX_COUNT] = {};
+    size_t mUsedSize = 0;
+    size_t mCapacity = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+class FreeList
+{
+public:
+    /// Heap slabs hold at least this many bytes of elements
+    constexpr static size_t SLAB_SIZE = 64 * 1024;
+    constexpr static size_t SLAB_MIN_COUNT = 4;
+
+public:
+    FreeList() noexcept = delete;
+
+    /**
+     * @brief Elements are carved from [begin, end) on demand, so untouched parts of the area are never written.
+     */
+    FreeList(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+            : mElementSize(elementSize),
+              mAlignment(alignment),
+              mUserBegin(begin),
+              mUserEnd(end)
+    {
+        init(begin, end, elementSize, alignment, extra);
+    }
+
+    FreeList(size_t elementSize, size_t alignment) noexcept
+            : mElementSize(elementSize),
+              mAlignment(alignment)
+    {
+    }
+
+    FreeList(const FreeList &rhs) = delete;
+
+    ~FreeList()
+    {
+        freeSlabs();
+    }
+
+    FreeList &operator=(const FreeList &rhs) = delete;
+
+    FreeList(FreeList &&rhs) noexcept
+    {
+        swap(*this, rhs);
+    }
+
+    FreeList &operator=(FreeList &&rhs) noexcept
+    {
+        swap(*this, rhs);
+        return *this;
+    }
+
+public:
+    void *pop() noexcept
+    {
+        Node *head = mHead;
+        if (head) {
+            mHead = head->next;
+            if (--mFreeCount < mIdleCount) {
+                mIdleCount = mFreeCount;
+            }
+        } else if (mPurged) {
+            // Purged pages are committed again on first touch
+            head = mPurged;
+            mPurged = head->next;
+        } else {
+            head = createNode();
+            GX_ASSERT(head);
+            if (head == nullptr) {
+                return nullptr;
+            }
+        }
+        ++mAllocCount;
+        return head;
+    }
+
+    void push(void *p) noexcept
+    {
+        GX_ASSERT(p);
+        if (p == nullptr) {
+            return;
+        }
+        Node *const head = static_cast<Node *>(p);
+        head->next = mHead;
+        mHead = head;
+        ++mFreeCount;
+        --mAllocCount;
+    }
+
+    /**
+     * @brief Pop up to n elements into out.
+     * @return Number of elements popped, less than n only when the heap is exhausted
+     */
+    size_t popBatch(void **out, size_t n) noexcept
+    {
+        size_t count = 0;
+        Node *node = mHead;
+        while (count < n && node) {
+            out[count++] = node;
+            node = node->next;
+        }
+        mHead = node;
+        mFreeCount -= count;
+        mIdleCount = std::min(mIdleCount, mFreeCount);
+
+        while (count < n && mPurged) {
+            out[count++] = mPurged;
+            mPurged = mPurged->next;
+        }
+        while (count < n) {
+            node = createNode();
+            if (node == nullptr) {
+                break;
+            }
+            out[count++] = node;
+        }
+        mAllocCount += count;
+        return count;
+    }
+
+    /**
+     * @brief Link the n elements into a chain and splice it in front of the list.
+     */
+    void pushBatch(void *const *in, size_t n) noexcept
+    {
+        if (n == 0) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < n; i++) {
+            GX_ASSERT(in[i]);
+            static_cast<Node *>(in[i])->next = static_cast<Node *>(in[i + 1]);
+        }
+        Node *const last = static_cast<Node *>(in[n - 1]);
+        GX_ASSERT(last);
+        last->next = mHead;
+        mHead = static_cast<Node *>(in[0]);
+        mFreeCount += n;
+        mAllocCount -= n;
+    }
+
+    void *getFirst() noexcept
+    {
+        return mHead;
+    }
+
+    /**
+     * @brief Free the heap slabs and start carving the user range again.
+     * Slabs are only freed as a whole, so while elements are still allocated
+     * the free elements are purged instead, see purge().
+     */
+    void clear() noexcept
+    {
+        if (mAllocCount > 0) {
+            purge(freeSize(), false);
+            return;
+        }
+        freeSlabs();
+        mHead = nullptr;
+        mPurged = nullptr;
+        mCarve = mUserFirst;
+        mNodeCount = 0;
+        mFreeCount = 0;
+        mIdleCount = 0;
+    }
+
+    /**
+     * @brief Give up to maxBytes of free elements back to the system, taken from the cold end of the list.
+     * Only the whole pages inside an element can be decommitted, so elements smaller than two pages
+     * are kept, as are larger ones that happen to hold no whole page after their link.
+     * Purged elements are reused only when the list runs dry.
+     * Every call also starts a new idle window, see idleSize().
+     * @param maxBytes
+     * @param idleOnly Only release elements that stayed free since the previous call
+     * @return Bytes actually decommitted
+     */
+    size_t purge(size_t maxBytes, bool idleOnly) noexcept
+    {
+        size_t released = 0;
+        const size_t count = idleOnly ? mIdleCount : mFreeCount;
+        if (count > 0 && mElementSize >= 2 * systemPageSize()) {
+            // The most recently freed elements are at the head, skip them
+            Node **link = &mHead;
+            for (size_t i = count; i < mFreeCount; i++) {
+                link = &(*link)->next;
+            }
+            while (*link && released + mElementSize <= maxBytes) {
+                Node *const node = *link;
+                const size_t size = decommitMemory(pointer::add(node, sizeof(Node)), pointer::add(node, mElementSize));
+                if (size == 0) {
+                    link = &node->next;
+                    continue;
+                }
+                *link = node->next;
+                node->next = mPurged;
+                mPurged = node;
+                --mFreeCount;
+                released += size;
+            }
+        }
+        mIdleCount = mFreeCount;
+        return released;
+    }
+
+    size_t size() const noexcept
+    {
+        return mAllocCount * mElementSize;
+    }
+
+    size_t capacity() const noexcept
+    {
+        size_t count = mNodeCount;
+        if (mCarve) {
+            count += (uintptr_t(mUserEnd) - uintptr_t(mCarve)) / mStride;
+        }
+        if (mSlabCarve) {
+            count += (uintptr_t(mSlabEnd) - uintptr_t(mSlabCarve)) / slabStride();
+        }
+        return count * mElementSize;
+    }
+
+    /**
+     * @brief Bytes of free elements ready for reuse, purged elements are not counted.
+     */
+    size_t freeSize() const noexcept
+    {
+        return mFreeCount * mElementSize;
+    }
+
+    /**
+     * @brief Bytes of free elements that were not used since the previous purge().
+     */
+    size_t idleSize() const noexcept
+    {
+        return mIdleCount * mElementSize;
+    }
+
+    friend void swap(FreeList &lhs, FreeList &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mElementSize, rhs.mElementSize);
+        swap(lhs.mAlignment, rhs.mAlignment);
+        swap(lhs.mHead, rhs.mHead);
+        swap(lhs.mPurged, rhs.mPurged);
+        swap(lhs.mUserBegin, rhs.mUserBegin);
+        swap(lhs.mUserEnd, rhs.mUserEnd);
+        swap(lhs.mUserFirst, rhs.mUserFirst);
+        swap(lhs.mCarve, rhs.mCarve);
+        swap(lhs.mStride, rhs.mStride);
+        swap(lhs.mSlabs, rhs.mSlabs);
+        swap(lhs.mSlabCarve, rhs.mSlabCarve);
+        swap(lhs.mSlabEnd, rhs.mSlabEnd);
+        swap(lhs.mAllocCount, rhs.mAllocCount);
+        swap(lhs.mNodeCount, rhs.mNodeCount);
+        swap(lhs.mFreeCount, rhs.mFreeCount);
+        swap(lhs.mIdleCount, rhs.mIdleCount);
+    }
+
+private:
+    struct Node
+    {
+        Node *next;
+    };
+
+    /// Header of a heap slab, the elements follow it
+    struct Slab
+    {
+        Slab *next;
+    };
+
+    void init(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    {
+        void *const p = pointer::align(begin, alignment, extra);
+        void *const n = pointer::align(pointer::add(p, elementSize), alignment, extra);
+        GX_ASSERT(n > p);
+
+        mStride = uintptr_t(n) - uintptr_t(p);
+        mUserFirst = pointer::add(p, mStride) <= end ? p : nullptr;
+        mCarve = mUserFirst;
+    }
+
+    Node *carveNode() noexcept
+    {
+        if (mCarve == nullptr) {
+            return nullptr;
+        }
+        Node *const node = static_cast<Node *>(mCarve);
+        void *const next = pointer::add(mCarve, mStride);
+        mCarve = pointer::add(next, mStride) <= mUserEnd ? next : nullptr;
+        return node;
+    }
+
+    /**
+     * @brief Carve a new element from the user range, then from the current heap slab,
+     * a new slab is allocated when both are exhausted.
+     */
+    Node *createNode() noexcept
+    {
+        Node *node = carveNode();
+        if (node == nullptr) {
+            if (mSlabCarve == nullptr && !createSlab()) {
+                return nullptr;
+            }
+            node = static_cast<Node *>(mSlabCarve);
+            void *const next = pointer::add(mSlabCarve, slabStride());
+            mSlabCarve = next < mSlabEnd ? next : nullptr;
+        }
+        ++mNodeCount;
+        return node;
+    }
+
+    bool createSlab() noexcept
+    {
+        const size_t stride = slabStride();
+        const size_t headerSize = pointer::alignSize(sizeof(Slab), mAlignment);
+        const size_t count = std::max(SLAB_MIN_COUNT, SLAB_SIZE / stride);
+        Slab *const slab = static_cast<Slab *>(alignedAlloc(headerSize + count * stride,
+                                                            std::max(mAlignment, alignof(Slab))));
+        if (slab == nullptr) {
+            return false;
+        }
+        slab->next = mSlabs;
+        mSlabs = slab;
+        mSlabCarve = pointer::add(slab, headerSize);
+        mSlabEnd = pointer::add(mSlabCarve, count * stride);
+        return true;
+    }
+
+    void freeSlabs() noexcept
+    {
+        while (mSlabs) {
+            Slab *const next = mSlabs->next;
+            alignedFree(mSlabs);
+            mSlabs = next;
+        }
+        mSlabCarve = nullptr;
+        mSlabEnd = nullptr;
+    }
+
+    size_t slabStride() const noexcept
+    {
+        return pointer::alignSize(mElementSize, mAlignment);
+    }
+
+private:
+    size_t mElementSize = 0;
+    size_t mAlignment = 0;
+    Node *mHead = nullptr;
+    /// Decommitted nodes
+    Node *mPurged = nullptr;
+    void *mUserBegin = nullptr;
+    void *mUserEnd = nullptr;
+    void *mUserFirst = nullptr;
+    void *mCarve = nullptr;
+    size_t mStride = 0;
+    Slab *mSlabs = nullptr;
+    void *mSlabCarve = nullptr;
+    void *mSlabEnd = nullptr;
+    size_t mAllocCount = 0;
+    /// Nodes carved from the user range or from the heap slabs
+    size_t mNodeCount = 0;
+    /// Nodes in the list starting at mHead
+    size_t mFreeCount = 0;
+    /// Lowest mFreeCount since the previous purge()
+    size_t mIdleCount = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @class AtomicFreeList
+ * @brief Lock-free version of FreeList (Treiber stack), pop() and push() can be called concurrently.
+ * Like SharedFreeList, links are element indices and the head packs a tag with the index of the first
+ * free element in one 64-bit word, the tag changes on every update and protects pop() from ABA
+ * with a plain 64-bit CAS.
+ * Indices first cover the user range, then heap slabs that double in size, so that an index maps back
+ * to its element without a lock. When empty, new elements are carved from the current slab,
+ * the first thread to reach a slab allocates it.
+ * clear() must not run concurrently with pop() / push().
+ */
+class AtomicFreeList
+{
+public:
+    constexpr static size_t SLAB_SIZE = FreeList::SLAB_SIZE;
+    constexpr static size_t SLAB_MIN_COUNT = FreeList::SLAB_MIN_COUNT;
+
+public:
+    AtomicFreeList() noexcept = delete;
+
+    AtomicFreeList(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+            : AtomicFreeList(elementSize, alignment)
+    {
+        init(begin, end, elementSize, alignment, extra);
+    }
+
+    AtomicFreeList(size_t elementSize, size_t alignment) noexcept
+            : mElementSize(elementSize),
+              mAlignment(alignment),
+              mSlabStride(pointer::alignSize(elementSize, alignment))
+    {
+        GX_ASSERT(elementSize >= sizeof(Node));
+        const size_t count = std::max(SLAB_MIN_COUNT, SLAB_SIZE / mSlabStride);
+        mSlabShift = details::highestBit(count);
+        if ((size_t(1) << mSlabShift) < count) {
+            ++mSlabShift;
+        }
+    }
+
+    AtomicFreeList(const AtomicFreeList &rhs) = delete;
+
+    AtomicFreeList(AtomicFreeList &&rhs) noexcept = delete;
+
+    ~AtomicFreeList()
+    {
+        freeSlabs();
+    }
+
+    AtomicFreeList &operator=(const AtomicFreeList &rhs) = delete;
+
+    AtomicFreeList &operator=(AtomicFreeList &&rhs) noexcept = delete;
+
+public:
+    void *pop() noexcept
+    {
+        uint64_t head = mHead.load(std::memory_order_acquire);
+        while (uint32_t(head)) {
+            Node *const node = nodeAt(uint32_t(head));
+            // The node may be popped by another thread meanwhile, the tag makes the CAS fail in that case
+            const uint64_t newHead = nextTag(head) | node->next.load(std::memory_order_relaxed);
+            if (mHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire)) {
+                mAllocCount.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+        }
+        Node *const node = carveNode();
+        GX_ASSERT(node);
+        if (node) {
+            mAllocCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    void push(void *p) noexcept
+    {
+        GX_ASSERT(p);
+        if (p == nullptr) {
+            return;
+        }
+        const uint32_t link = linkOf(p);
+        Node *const node = new(p) Node;
+        uint64_t head = mHead.load(std::memory_order_relaxed);
+        do {
+            node->next.store(uint32_t(head), std::memory_order_relaxed);
+        } while (!mHead.compare_exchange_weak(head, nextTag(head) | link, std::memory_order_release,
+                                              std::memory_order_relaxed));
+        mAllocCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pop up to n elements into out, one CAS per element:
+     * detaching a run of nodes is not safe while other threads pop.
+     * @return Number of elements popped
+     */
+    size_t popBatch(void **out, size_t n) noexcept
+    {
+        size_t count = 0;
+        while (count < n) {
+            void *p = pop();
+            if (p == nullptr) {
+                break;
+            }
+            out[count++] = p;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Link the n elements into a chain and splice it in front of the list with a single CAS.
+     */
+    void pushBatch(void *const *in, size_t n) noexcept
+    {
+        if (n == 0) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < n; i++) {
+            GX_ASSERT(in[i]);
+            const uint32_t next = linkOf(in[i + 1]);
+            Node *const node = new(in[i]) Node;
+            node->next.store(next, std::memory_order_relaxed);
+        }
+        GX_ASSERT(in[n - 1]);
+        const uint32_t first = linkOf(in[0]);
+        Node *const last = new(in[n - 1]) Node;
+        uint64_t head = mHead.load(std::memory_order_relaxed);
+        do {
+            last->next.store(uint32_t(head), std::memory_order_relaxed);
+        } while (!mHead.compare_exchange_weak(head, nextTag(head) | first, std::memory_order_release,
+                                              std::memory_order_relaxed));
+        mAllocCount.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    void *getFirst() noexcept
+    {
+        const uint32_t link = uint32_t(mHead.load(std::memory_order_relaxed));
+        return link ? nodeAt(link) : nullptr;
+    }
+
+    /**
+     * @brief Free the heap slabs and start carving the user range again.
+     * Slabs are only freed as a whole, nothing happens while elements are still allocated.
+     */
+    void clear() noexcept
+    {
+        if (mAllocCount.load(std::memory_order_relaxed) > 0) {
+            return;
+        }
+        freeSlabs();
+        mHead.store(0, std::memory_order_relaxed);
+        mCarve.store(0, std::memory_order_relaxed);
+    }
+
+    size_t size() const noexcept
+    {
+        return mAllocCount.load(std::memory_order_relaxed) * mElementSize;
+    }
+
+    size_t capacity() const noexcept
+    {
+        size_t count = mUserCount;
+        for (uint32_t k = 0; k < MAX_SLAB_COUNT && mSlabs[k].load(std::memory_order_relaxed); k++) {
+            count += slabCount(k);
+        }
+        return count * mElementSize;
+    }
+
+private:
+    /// Slab k holds 2^(mSlabShift + k) elements, 32 slabs cover every 32-bit index
+    constexpr static uint32_t MAX_SLAB_COUNT = 32;
+
+    struct Node
+    {
+        /// index + 1 of the next free element, 0 at the end
+        std::atomic<uint32_t> next;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "AtomicFreeList needs a lock-free 64-bit CAS");
+
+    static uint64_t nextTag(uint64_t head) noexcept
+    {
+        return ((head >> 32) + 1) << 32;
+    }
+
+    void init(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    {
+        void *const p = pointer::align(begin, alignment, extra);
+        void *const n = pointer::align(pointer::add(p, elementSize), alignment, extra);
+        GX_ASSERT(n > p);
+
+        mStride = uintptr_t(n) - uintptr_t(p);
+        mUserFirst = p;
+        mUserCount = p < end ? (uintptr_t(end) - uintptr_t(p)) / mStride : 0;
+        mUserCount = std::min<size_t>(mUserCount, UINT32_MAX - 1);
+    }
+
+    size_t slabCount(uint32_t k) const noexcept
+    {
+        return size_t(1) << (mSlabShift + k);
+    }
+
+    /**
+     * @brief Slab k starts at heap index (2^k - 1) * 2^mSlabShift.
+     */
+    uint32_t slabOf(size_t heapIndex) const noexcept
+    {
+        return details::highestBit((heapIndex >> mSlabShift) + 1);
+    }
+
+    Node *nodeAt(uint32_t link) const noexcept
+    {
+        const size_t index = link - 1;
+        if (index < mUserCount) {
+            return static_cast<Node *>(pointer::add(mUserFirst, index * mStride));
+        }
+        const size_t heapIndex = index - mUserCount;
+        const uint32_t k = slabOf(heapIndex);
+        void *const slab = mSlabs[k].load(std::memory_order_acquire);
+        return static_cast<Node *>(pointer::add(slab, (heapIndex - (slabCount(k) - (size_t(1) << mSlabShift)))
+                                                      * mSlabStride));
+    }
+
+    uint32_t linkOf(const void *p) const noexcept
+    {
+        const uintptr_t offset = uintptr_t(p) - uintptr_t(mUserFirst);
+        if (p >= mUserFirst && offset < mUserCount * mStride) {
+            GX_ASSERT(offset % mStride == 0);
+            return uint32_t(offset / mStride + 1);
+        }
+        size_t heapIndex = 0;
+        for (uint32_t k = 0; k < MAX_SLAB_COUNT; k++) {
+            void *const slab = mSlabs[k].load(std::memory_order_acquire);
+            if (slab == nullptr) {
+                break;
+            }
+            const uintptr_t slabOffset = uintptr_t(p) - uintptr_t(slab);
+            if (p >= slab && slabOffset < slabCount(k) * mSlabStride) {
+                GX_ASSERT(slabOffset % mSlabStride == 0);
+                return uint32_t(mUserCount + heapIndex + slabOffset / mSlabStride + 1);
+            }
+            heapIndex += slabCount(k);
+        }
+        GX_ASSERT_S(false, "AtomicFreeList: the element does not belong to this list");
+        return 0;
+    }
+
+    /**
+     * @brief Take the next index that was never used, the first thread to reach a heap slab allocates it.
+     */
+    Node *carveNode() noexcept
+    {
+        // Overshooting is harmless, the cursor is only compared against the limits
+        const size_t index = mCarve.fetch_add(1, std::memory_order_relaxed);
+        if (index >= UINT32_MAX - 1) {
+            return nullptr;
+        }
+        if (index < mUserCount) {
+            return static_cast<Node *>(pointer::add(mUserFirst, index * mStride));
+        }
+        const uint32_t k = slabOf(index - mUserCount);
+        if (mSlabs[k].load(std::memory_order_acquire) == nullptr) {
+            void *const slab = alignedAlloc(slabCount(k) * mSlabStride, mAlignment);
+            if (slab == nullptr) {
+                return nullptr;
+            }
+            void *expected = nullptr;
+            if (!mSlabs[k].compare_exchange_strong(expected, slab, std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+                alignedFree(slab);
+            }
+        }
+        return nodeAt(uint32_t(index + 1));
+    }
+
+    void freeSlabs() noexcept
+    {
+        for (auto &slab: mSlabs) {
+            alignedFree(slab.exchange(nullptr, std::memory_order_relaxed));
+        }
+    }
+
+private:
+    size_t mElementSize = 0;
+    size_t mAlignment = 0;
+    /// Tag in the high half against ABA, index + 1 of the first free element in the low half, 0 when empty
+    std::atomic<uint64_t> mHead{0};
+    void *mUserFirst = nullptr;
+    size_t mUserCount = 0;
+    size_t mStride = 0;
+    size_t mSlabStride = 0;
+    uint32_t mSlabShift = 0;
+    std::atomic<size_t> mCarve{0};
+    std::atomic<void *> mSlabs[MAX_SLAB_COUNT] = {};
+    std::atomic<size_t> mAllocCount{0};
+};
+
+/**
+ * @class SharedFreeList
+ * @brief Lock-free FreeList whose whole state lives at the start of its area, for SharedMemoryArea.
+ * Links are element indices relative to the area instead of pointers, so processes that map the area
+ * at different addresses share one pool. The first process to attach lays out the header,
+ * the others wait for it (up to details::SHARED_ATTACH_TIMEOUT) and check that the element size matches.
+ * The area must be zero-filled when first attached (new shared memory is).
+ * There is no heap fallback, pop() returns nullptr when the area is exhausted.
+ * clear() resets the pool for every process and must not run concurrently with pop() / push().
+ */
+class SharedFreeList
+{
+public:
+    SharedFreeList() noexcept = delete;
+
+    SharedFreeList(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    {
+        attach(begin, end, elementSize, alignment, extra);
+    }
+
+    SharedFreeList(size_t, size_t) noexcept
+    {}
+
+    SharedFreeList(const SharedFreeList &rhs) = delete;
+
+    SharedFreeList(SharedFreeList &&rhs) noexcept = delete;
+
+    ~SharedFreeList() noexcept = default;
+
+    SharedFreeList &operator=(const SharedFreeList &rhs) = delete;
+
+    SharedFreeList &operator=(SharedFreeList &&rhs) noexcept = delete;
+
+public:
+    void *pop() noexcept
+    {
+        if (mHeader == nullptr) {
+            return nullptr;
+        }
+        uint64_t head = mHeader->head.load(std::memory_order_acquire);
+        while (uint32_t(head)) {
+            Node *const node = nodeAt(uint32_t(head));
+            // The node may be popped by another process meanwhile, the tag makes the CAS fail in that case
+            const uint64_t newHead = nextTag(head) | node->next.load(std::memory_order_relaxed);
+            if (mHeader->head.compare_exchange_weak(head, newHead, std::memory_order_acquire,
+                                                    std::memory_order_acquire)) {
+                mHeader->allocCount.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+        }
+        // Overshooting the count is harmless, the cursor is only compared against it
+        const uint64_t index = mHeader->carve.fetch_add(1, std::memory_order_relaxed);
+        if (index >= mHeader->elementCount) {
+            return nullptr;
+        }
+        mHeader->allocCount.fetch_add(1, std::memory_order_relaxed);
+        return pointer::add(mElements, index * mHeader->stride);
+    }
+
+    void push(void *p) noexcept
+    {
+        GX_ASSERT(p);
+        if (p == nullptr) {
+            return;
+        }
+        Node *const node = new(p) Node;
+        const uint32_t link = linkOf(p);
+        uint64_t head = mHeader->head.load(std::memory_order_relaxed);
+        do {
+            node->next.store(uint32_t(head), std::memory_order_relaxed);
+        } while (!mHeader->head.compare_exchange_weak(head, nextTag(head) | link, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+        mHeader->allocCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    size_t popBatch(void **out, size_t n) noexcept
+    {
+        size_t count = 0;
+        while (count < n) {
+            void *p = pop();
+            if (p == nullptr) {
+                break;
+            }
+            out[count++] = p;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Link the n elements into a chain and splice it in front of the list with a single CAS.
+     */
+    void pushBatch(void *const *in, size_t n) noexcept
+    {
+        if (n == 0) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < n; i++) {
+            GX_ASSERT(in[i]);
+            Node *const node = new(in[i]) Node;
+            node->next.store(linkOf(in[i + 1]), std::memory_order_relaxed);
+        }
+        GX_ASSERT(in[n - 1]);
+        Node *const last = new(in[n - 1]) Node;
+        const uint32_t first = linkOf(in[0]);
+        uint64_t head = mHeader->head.load(std::memory_order_relaxed);
+        do {
+            last->next.store(uint32_t(head), std::memory_order_relaxed);
+        } while (!mHeader->head.compare_exchange_weak(head, nextTag(head) | first, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+        mHeader->allocCount.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    void *getFirst() noexcept
+    {
+        if (mHeader == nullptr) {
+            return nullptr;
+        }
+        const uint32_t link = uint32_t(mHeader->head.load(std::memory_order_relaxed));
+        return link ? nodeAt(link) : nullptr;
+    }
+
+    void clear() noexcept
+    {
+        if (mHeader) {
+            mHeader->head.store(0, std::memory_order_relaxed);
+            mHeader->carve.store(0, std::memory_order_relaxed);
+            mHeader->allocCount.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        return mHeader ? size_t(mHeader->allocCount.load(std::memory_order_relaxed)) * mHeader->elementSize : 0;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return mHeader ? size_t(mHeader->elementCount) * mHeader->elementSize : 0;
+    }
+
+    /**
+     * @brief Position of an element in the area, valid in every process.
+     */
+    uint64_t offsetOf(const void *p) const noexcept
+    {
+        return uintptr_t(p) - uintptr_t(mHeader);
+    }
+
+    void *at(uint64_t offset) const noexcept
+    {
+        return pointer::add(mHeader, offset);
+    }
+
+private:
+    constexpr static uint32_t MAGIC = 0x47584c46; // "GXLF"
+
+    enum State : uint32_t
+    {
+        Empty = 0,
+        Initializing = 1,
+        Ready = 2,
+    };
+
+    /// Lives at the start of the area, shared by every process
+    struct Header
+    {
+        std::atomic<uint32_t> state;
+        uint32_t magic;
+        uint64_t elementSize;
+        uint64_t stride;
+        uint64_t elementsOffset;
+        uint64_t elementCount;
+        /// Tag in the high half against ABA, index + 1 of the first free element in the low half, 0 when empty
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> carve;
+        std::atomic<uint64_t> allocCount;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                  "SharedFreeList needs address-free atomics");
+
+    struct Node
+    {
+        /// index + 1 of the next free element, 0 at the end
+        std::atomic<uint32_t> next;
+    };
+
+    static uint64_t nextTag(uint64_t head) noexcept
+    {
+        return ((head >> 32) + 1) << 32;
+    }
+
+    Node *nodeAt(uint32_t link) const noexcept
+    {
+        return static_cast<Node *>(pointer::add(mElements, (link - 1) * mHeader->stride));
+    }
+
+    uint32_t linkOf(const void *p) const noexcept
+    {
+        const uint64_t offset = uintptr_t(p) - uintptr_t(mElements);
+        GX_ASSERT(p >= mElements && offset % mHeader->stride == 0);
+        return uint32_t(offset / mHeader->stride + 1);
+    }
+
+    void attach(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    {
+        if (begin == nullptr || pointer::add(begin, sizeof(Header)) > end) {
+            return;
+        }
+        GX_ASSERT_S(uintptr_t(begin) % alignof(Header) == 0, "SharedFreeList: misaligned area");
+        Header *const header = static_cast<Header *>(begin);
+
+        uint32_t state = Empty;
+        if (header->state.compare_exchange_strong(state, Initializing, std::memory_order_acquire)) {
+            // Elements are placed relative to the area start, which is page aligned in every process
+            void *const p = pointer::align(pointer::add(begin, sizeof(Header)), alignment, extra);
+            void *const n = pointer::align(pointer::add(p, elementSize), alignment, extra);
+            GX_ASSERT(n > p);
+
+            header->magic = MAGIC;
+            header->elementSize = elementSize;
+            header->stride = uintptr_t(n) - uintptr_t(p);
+            header->elementsOffset = uintptr_t(p) - uintptr_t(begin);
+            header->elementCount = p < end ? (uintptr_t(end) - uintptr_t(p)) / header->stride : 0;
+            header->elementCount = std::min<uint64_t>(header->elementCount, UINT32_MAX - 1);
+            header->head.store(0, std::memory_order_relaxed);
+            header->carve.store(0, std::memory_order_relaxed);
+            header->allocCount.store(0, std::memory_order_relaxed);
+            header->state.store(Ready, std::memory_order_release);
+        } else if (!details::waitSharedHeader(header->state, Ready)) {
+            GX_ASSERT_S(false, "SharedFreeList: the area was never initialized, recreate it");
+            return;
+        }
+        if (header->magic != MAGIC || header->elementSize != elementSize) {
+            GX_ASSERT_S(false, "SharedFreeList: the area holds a different pool");
+            return;
+        }
+        mHeader = header;
+        mElements = pointer::add(begin, header->elementsOffset);
+    }
+
+private:
+    Header *mHeader = nullptr;
+    void *mElements = nullptr;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @class PoolAllocator
+ *
+ * For memory pool allocation of fixed large and small blocks,
+ * Only memory within a fixed size can be allocated at a time,
+ * A certain size of continuous memory can be pre allocated as the initial memory block of the pool,
+ * The default FreeList will allocate more memory after the original memory block is exhausted,
+ * These memory that has not been allocated can be reclaimed using reset, and will also be reclaimed during PoolAllocator deconstruction,
+ * Before disassembling PoolAllocator, it is important to free all allocated memory blocks, otherwise it will cause memory leakage
+ *
+ * @tparam ELEMENT_SIZE Element size (byte) must be greater than or equal to sizeof (void *)
+ * @tparam ALIGNMENT    Alignment during element memory allocation
+ * @tparam OFFSET       Offset for element memory alignment
+ * @tparam FREELIST     FreeList, or AtomicFreeList for a lock-free pool (use it with LockingPolicy::NoLock),
+ *                      or SharedFreeList for a pool inside a SharedMemoryArea
+ */
+template<size_t ELEMENT_SIZE,
+        size_t ALIGNMENT = alignof(std::max_align_t),
+        size_t OFFSET = 0,
+        typename FREELIST = FreeList>
+class PoolAllocator
+{
+private:
+    /// At least one Node pointer size must be accommodated
+    static_assert(ELEMENT_SIZE >= sizeof(void *), "ELEMENT_SIZE must accommodate at least a pointer");
+
+public:
+    PoolAllocator() noexcept
+            : mFreeList(ELEMENT_SIZE, ALIGNMENT)
+    {
+    }
+
+    PoolAllocator(void *begin, void *end) noexcept
+            : mFreeList(begin, end, ELEMENT_SIZE, ALIGNMENT, OFFSET)
+    {
+    }
+
+    template<typename AREA>
+    explicit PoolAllocator(const AREA &area) noexcept
+            : PoolAllocator(area.begin(), area.end())
+    {
+    }
+
+    PoolAllocator(const PoolAllocator &rhs) = delete;
+
+    PoolAllocator &operator=(const PoolAllocator &rhs) = delete;
+
+    PoolAllocator(PoolAllocator &&rhs) noexcept = default;
+
+    PoolAllocator &operator=(PoolAllocator &&rhs) noexcept = default;
+
+    ~PoolAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size = ELEMENT_SIZE,
+                size_t alignment = ALIGNMENT, size_t offset = OFFSET) noexcept
+    {
+        GX_ASSERT(size <= ELEMENT_SIZE);
+        GX_ASSERT(alignment <= ALIGNMENT);
+        GX_ASSERT(offset == OFFSET);
+        return mFreeList.pop();
+    }
+
+    void free(void *p, size_t = ELEMENT_SIZE) noexcept
+    {
+        mFreeList.push(p);
+    }
+
+    /**
+     * @brief Allocate up to n elements into out.
+     * @return Number of elements allocated
+     */
+    size_t allocBatch(void **out, size_t n) noexcept
+    {
+        return mFreeList.popBatch(out, n);
+    }
+
+    void freeBatch(void *const *in, size_t n) noexcept
+    {
+        mFreeList.pushBatch(in, n);
+    }
+
+    size_t size() const noexcept
+    {
+        return mFreeList.size();
+    }
+
+    size_t capacity() const noexcept
+    {
+        return mFreeList.capacity();
+    }
+
+    size_t elementSize() const noexcept
+    {
+        return ELEMENT_SIZE;
+    }
+
+    void *getCurrent() noexcept
+    {
+        return mFreeList.getFirst();
+    }
+
+    void reset() noexcept
+    {
+        mFreeList.clear();
+    }
+
+    /**
+     * @brief Give free elements back to the system, only with FreeList, see FreeList::purge().
+     */
+    size_t purge(size_t maxBytes, bool idleOnly = true) noexcept
+    {
+        return mFreeList.purge(maxBytes, idleOnly);
+    }
+
+    size_t freeSize() const noexcept
+    {
+        return mFreeList.freeSize();
+    }
+
+    size_t idleSize() const noexcept
+    {
+        return mFreeList.idleSize();
+    }
+
+private:
+    FREELIST mFreeList;
+};
+
+template<typename T, size_t ALIGNMENT = alignof(T), size_t OFFSET = 0>
+using ObjectPoolAllocator = PoolAllocator<sizeof(T), ALIGNMENT, OFFSET>;
+
+template<size_t ELEMENT_SIZE, size_t ALIGNMENT = alignof(std::max_align_t), size_t OFFSET = 0>
+using AtomicPoolAllocator = PoolAllocator<ELEMENT_SIZE, ALIGNMENT, OFFSET, AtomicFreeList>;
+
+template<typename T, size_t ALIGNMENT = alignof(T), size_t OFFSET = 0>
+using AtomicObjectPoolAllocator = PoolAllocator<sizeof(T), ALIGNMENT, OFFSET, AtomicFreeList>;
+
+/// Pool inside a SharedMemoryArea, shared by the processes that map it (use it with LockingPolicy::NoLock)
+template<size_t ELEMENT_SIZE, size_t ALIGNMENT = alignof(std::max_align_t), size_t OFFSET = 0>
+using SharedPoolAllocator = PoolAllocator<ELEMENT_SIZE, ALIGNMENT, OFFSET, SharedFreeList>;
+
+namespace details
+{
+
+/**
+ * @brief Upper bound of the block std::allocate_shared() asks for in Pond::makeShared<T>():
+ * the control block (vtable, two counters, the pond allocator) followed by T.
+ */
+template<typename T>
+constexpr size_t sharedPtrBlockSize() noexcept
+{
+    constexpr size_t header = 2 * sizeof(void *) + 2 * sizeof(long);
+    constexpr size_t alignment = std::max(alignof(T), alignof(void *));
+    return (header + alignment - 1) / alignment * alignment + sizeof(T);
+}
+
+}
+
+/// Pool whose elements hold T together with its shared_ptr control block, for Pond::makeShared<T>()
+template<typename T, typename FREELIST = FreeList>
+using SharedPtrPoolAllocator = PoolAllocator<details::sharedPtrBlockSize<T>(), std::max(alignof(T), alignof(void *)),
+                                             0, FREELIST>;
+
+/**
+ * @class DynamicPoolAllocator
+ * @brief Same as PoolAllocator, but the element size is chosen at runtime,
+ * so that pools of different element sizes share one type (e.g. size classes).
+ */
+class DynamicPoolAllocator
+{
+public:
+    explicit DynamicPoolAllocator(size_t elementSize, size_t alignment = alignof(std::max_align_t)) noexcept
+            : mFreeList(elementSize, alignment),
+              mElementSize(elementSize),
+              mAlignment(alignment)
+    {
+        GX_ASSERT(elementSize >= sizeof(void *));
+    }
+
+    DynamicPoolAllocator(void *begin, void *end,
+                         size_t elementSize, size_t alignment = alignof(std::max_align_t)) noexcept
+            : mFreeList(begin, end, elementSize, alignment, 0),
+              mElementSize(elementSize),
+              mAlignment(alignment)
+    {
+        GX_ASSERT(elementSize >= sizeof(void *));
+    }
+
+    template<typename AREA>
+    DynamicPoolAllocator(const AREA &area,
+                         size_t elementSize, size_t alignment = alignof(std::max_align_t)) noexcept
+            : DynamicPoolAllocator(area.begin(), area.end(), elementSize, alignment)
+    {
+    }
+
+    DynamicPoolAllocator(const DynamicPoolAllocator &rhs) = delete;
+
+    DynamicPoolAllocator &operator=(const DynamicPoolAllocator &rhs) = delete;
+
+    DynamicPoolAllocator(DynamicPoolAllocator &&rhs) noexcept = default;
+
+    DynamicPoolAllocator &operator=(DynamicPoolAllocator &&rhs) noexcept = default;
+
+    ~DynamicPoolAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t offset = 0) noexcept
+    {
+        GX_ASSERT(size <= mElementSize);
+        GX_ASSERT(alignment <= mAlignment || alignment <= sizeof(void *));
+        GX_ASSERT(offset == 0);
+        return mFreeList.pop();
+    }
+
+    void free(void *p, size_t = 0) noexcept
+    {
+        mFreeList.push(p);
+    }
+
+    /**
+     * @brief Allocate up to n elements into out.
+     * @return Number of elements allocated
+     */
+    size_t allocBatch(void **out, size_t n) noexcept
+    {
+        return mFreeList.popBatch(out, n);
+    }
+
+    void freeBatch(void *const *in, size_t n) noexcept
+    {
+        mFreeList.pushBatch(in, n);
+    }
+
+    size_t size() const noexcept
+    {
+        return mFreeList.size();
+    }
+
+    size_t capacity() const noexcept
+    {
+        return mFreeList.capacity();
+    }
+
+    size_t elementSize() const noexcept
+    {
+        return mElementSize;
+    }
+
+    void *getCurrent() noexcept
+    {
+        return mFreeList.getFirst();
+    }
+
+    void reset() noexcept
+    {
+        mFreeList.clear();
+    }
+
+    /**
+     * @brief Give free elements back to the system, see FreeList::purge().
+     */
+    size_t purge(size_t maxBytes, bool idleOnly = true) noexcept
+    {
+        return mFreeList.purge(maxBytes, idleOnly);
+    }
+
+    size_t freeSize() const noexcept
+    {
+        return mFreeList.freeSize();
+    }
+
+    size_t idleSize() const noexcept
+    {
+        return mFreeList.idleSize();
     }
 
 private:
     FreeList mFreeList;
+    size_t mElementSize;
+    size_t mAlignment;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Areas
+// ------------------------------------------------------------------------------------------------
+
+class HeapArea
+{
+public:
+    HeapArea() noexcept = default;
+
+    explicit HeapArea(size_t size)
+    {
+        if (size) {
+            mBegin = malloc(size);
+            mEnd = pointer::add(mBegin, size);
+        }
+    }
+
+    ~HeapArea() noexcept
+    {
+        free(mBegin);
+    }
+
+    HeapArea(const HeapArea &rhs) = delete;
+
+    HeapArea &operator=(const HeapArea &rhs) = delete;
+
+    HeapArea(HeapArea &&rhs) noexcept = delete;
+
+    HeapArea &operator=(HeapArea &&rhs) noexcept = delete;
+
+public:
+    void *data() const noexcept
+    { return mBegin; }
+
+    void *begin() const noexcept
+    { return mBegin; }
+
+    void *end() const noexcept
+    { return mEnd; }
+
+    size_t size() const noexcept
+    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+
+    friend void swap(HeapArea &lhs, HeapArea &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mBegin, rhs.mBegin);
+        swap(lhs.mEnd, rhs.mEnd);
+    }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+};
+
+/**
+ * @class HugePageArea
+ * @brief Area backed by an anonymous memory mapping (VirtualAlloc on Windows).
+ * The range is only reserved, physical pages are committed by the OS when first touched,
+ * so an untouched reservation costs no RSS.
+ * On Linux it can also be backed by huge pages to reduce TLB misses:
+ * HugePages tries MAP_HUGETLB first (needs reserved hugetlbfs pages) and falls back to TransparentHugePages,
+ * which aligns the range to 2M and applies madvise(MADV_HUGEPAGE).
+ * Populate commits every page up front, for latency-critical pools.
+ */
+class GX_API HugePageArea
+{
+public:
+    enum Flags : uint32_t
+    {
+        None = 0,
+        HugePages = 1 << 0,
+        TransparentHugePages = 1 << 1,
+        Populate = 1 << 2,
+    };
+
+public:
+    HugePageArea() noexcept = default;
+
+    explicit HugePageArea(size_t size, uint32_t flags = TransparentHugePages);
+
+    ~HugePageArea() noexcept;
+
+    HugePageArea(const HugePageArea &rhs) = delete;
+
+    HugePageArea &operator=(const HugePageArea &rhs) = delete;
+
+    HugePageArea(HugePageArea &&rhs) noexcept
+    {
+        swap(*this, rhs);
+    }
+
+    HugePageArea &operator=(HugePageArea &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            swap(*this, rhs);
+        }
+        return *this;
+    }
+
+public:
+    void *data() const noexcept
+    { return mBegin; }
+
+    void *begin() const noexcept
+    { return mBegin; }
+
+    void *end() const noexcept
+    { return mEnd; }
+
+    size_t size() const noexcept
+    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+
+    /**
+     * @brief Whether the area is backed by explicit (hugetlbfs) huge pages.
+     * @return
+     */
+    bool isHugeTlb() const noexcept
+    { return mHugeTlb; }
+
+    friend void swap(HugePageArea &lhs, HugePageArea &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mBegin, rhs.mBegin);
+        swap(lhs.mEnd, rhs.mEnd);
+        swap(lhs.mMapSize, rhs.mMapSize);
+        swap(lhs.mHugeTlb, rhs.mHugeTlb);
+    }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+    size_t mMapSize = 0;
+    bool mHugeTlb = false;
+};
+
+/**
+ * NUMA topology helpers, they report a single node where NUMA is not available.
+ */
+namespace numa
+{
+
+/**
+ * @brief Number of NUMA nodes, 1 when the system has no NUMA or it cannot be queried.
+ */
+GX_API uint32_t nodeCount() noexcept;
+
+/**
+ * @brief Node of the CPU the calling thread is running on, 0 when unknown.
+ * The thread may migrate right after the call, the result is a placement hint.
+ */
+GX_API uint32_t currentNode() noexcept;
+
+/**
+ * @brief Prefer node for pages first touched by the calling thread (set_mempolicy), e.g. for pinned workers.
+ * @return false if the policy could not be applied
+ */
+GX_API bool preferNode(uint32_t node) noexcept;
+
+/**
+ * @brief Prefer node for the pages of [addr, addr + size) (mbind), must be called before they are touched.
+ * @return false if the policy could not be applied, the pages then follow the first touch
+ */
+GX_API bool bindMemory(void *addr, size_t size, uint32_t node) noexcept;
+
+}
+
+/**
+ * @class NumaArea
+ * @brief Anonymous mapping whose pages are placed on one NUMA node.
+ * On Linux the range is bound with mbind(MPOL_PREFERRED), on Windows it comes from VirtualAllocExNuma.
+ * When binding is not possible the pages land on the node of the thread that touches them first,
+ * so an area filled by threads of its node is still local.
+ * With a single node it is a plain mapping.
+ */
+class GX_API NumaArea
+{
+public:
+    NumaArea() noexcept = default;
+
+    /**
+     * @param size
+     * @param node
+     * @param populate Commit every page up front (after binding)
+     */
+    NumaArea(size_t size, uint32_t node, bool populate = false);
+
+    ~NumaArea() noexcept;
+
+    NumaArea(const NumaArea &rhs) = delete;
+
+    NumaArea &operator=(const NumaArea &rhs) = delete;
+
+    NumaArea(NumaArea &&rhs) noexcept
+    {
+        swap(*this, rhs);
+    }
+
+    NumaArea &operator=(NumaArea &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            swap(*this, rhs);
+        }
+        return *this;
+    }
+
+public:
+    void *data() const noexcept
+    { return mBegin; }
+
+    void *begin() const noexcept
+    { return mBegin; }
+
+    void *end() const noexcept
+    { return mEnd; }
+
+    size_t size() const noexcept
+    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+
+    uint32_t node() const noexcept
+    { return mNode; }
+
+    /**
+     * @brief Whether the pages are bound to the node, otherwise they follow the first touch.
+     */
+    bool isBound() const noexcept
+    { return mBound; }
+
+    friend void swap(NumaArea &lhs, NumaArea &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mBegin, rhs.mBegin);
+        swap(lhs.mEnd, rhs.mEnd);
+        swap(lhs.mMapSize, rhs.mMapSize);
+        swap(lhs.mNode, rhs.mNode);
+        swap(lhs.mBound, rhs.mBound);
+    }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+    size_t mMapSize = 0;
+    uint32_t mNode = 0;
+    bool mBound = false;
 };
 
-template<typename T, size_t ALIGNMENT = alignof(T), size_t OFFSET = 0>
-using ObjectPoolAllocator = PoolAllocator<sizeof(T), ALIGNMENT, OFFSET>;
+/**
+ * @class SharedMemoryArea
+ * @brief Area backed by shared memory that cooperating processes map at the same time.
+ * Anonymous areas use memfd_create (shm_open + shm_unlink elsewhere, an unnamed file mapping on Windows),
+ * they are shared by fork() or by passing handle() to another process, which attaches with
+ * SharedMemoryArea(handle, size).
+ * Named areas use shm_open (a named file mapping on Windows), call unlink() when no new process needs to open it.
+ * New memory is zero-filled. Each process may map the area at a different address,
+ * so anything stored inside it refers to other parts of it by offset (see offsetOf() / at()),
+ * the shared allocators (SharedPoolAllocator, SharedLinearAllocator) keep their state in the area for this reason.
+ */
+class GX_API SharedMemoryArea
+{
+public:
+#if GX_PLATFORM_WINDOWS
+    using NativeHandle = void *;
+#else
+    using NativeHandle = int;
+#endif
 
-// ------------------------------------------------------------------------------------------------
-// Areas
-// ------------------------------------------------------------------------------------------------
+    enum Mode
+    {
+        Create,
+        Open,
+        OpenOrCreate,
+    };
 
-class HeapArea
-{
 public:
-    HeapArea() noexcept = default;
+    SharedMemoryArea() noexcept = default;
 
-    explicit HeapArea(size_t size)
+    /**
+     * @brief Anonymous area.
+     */
+    explicit SharedMemoryArea(size_t size);
+
+    /**
+     * @brief Named area, name is a single path component, e.g. "/worker-buffers".
+     * @param size Ignored when opening an existing area, 0 to open only
+     */
+    SharedMemoryArea(const char *name, size_t size, Mode mode = OpenOrCreate);
+
+    /**
+     * @brief Attach to an area received from another process, the handle is duplicated.
+     * @param size 0 to map the whole object (POSIX only)
+     */
+    SharedMemoryArea(NativeHandle handle, size_t size);
+
+    ~SharedMemoryArea() noexcept;
+
+    SharedMemoryArea(const SharedMemoryArea &rhs) = delete;
+
+    SharedMemoryArea &operator=(const SharedMemoryArea &rhs) = delete;
+
+    SharedMemoryArea(SharedMemoryArea &&rhs) noexcept
     {
-        if (size) {
-            mBegin = malloc(size);
-            mEnd = pointer::add(mBegin, size);
+        swap(*this, rhs);
+    }
+
+    SharedMemoryArea &operator=(SharedMemoryArea &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            swap(*this, rhs);
         }
+        return *this;
     }
 
-    ~HeapArea() noexcept
+public:
+    void *data() const noexcept
+    { return mBegin; }
+
+    void *begin() const noexcept
+    { return mBegin; }
+
+    void *end() const noexcept
+    { return mEnd; }
+
+    size_t size() const noexcept
+    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+
+    bool isValid() const noexcept
+    { return mBegin != nullptr; }
+
+    /**
+     * @brief Whether this process created the shared memory object.
+     */
+    bool isCreator() const noexcept
+    { return mCreator; }
+
+    NativeHandle handle() const noexcept
+    { return mHandle; }
+
+    /**
+     * @brief Position of p in the area, valid in every process that maps it.
+     */
+    uint64_t offsetOf(const void *p) const noexcept
     {
-        free(mBegin);
+        GX_ASSERT(p >= mBegin && p < mEnd);
+        return uintptr_t(p) - uintptr_t(mBegin);
     }
 
-    HeapArea(const HeapArea &rhs) = delete;
+    void *at(uint64_t offset) const noexcept
+    {
+        GX_ASSERT(offset < size());
+        return pointer::add(mBegin, offset);
+    }
 
-    HeapArea &operator=(const HeapArea &rhs) = delete;
+    /**
+     * @brief Remove a named area, processes that mapped it keep their mapping.
+     * No-op on Windows, where the mapping is removed with its last handle.
+     */
+    static bool unlink(const char *name) noexcept;
 
-    HeapArea(HeapArea &&rhs) noexcept = delete;
+    friend void swap(SharedMemoryArea &lhs, SharedMemoryArea &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mBegin, rhs.mBegin);
+        swap(lhs.mEnd, rhs.mEnd);
+        swap(lhs.mHandle, rhs.mHandle);
+        swap(lhs.mCreator, rhs.mCreator);
+    }
 
-    HeapArea &operator=(HeapArea &&rhs) noexcept = delete;
+private:
+    bool map(size_t size) noexcept;
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+#if GX_PLATFORM_WINDOWS
+    NativeHandle mHandle = nullptr;
+#else
+    NativeHandle mHandle = -1;
+#endif
+    bool mCreator = false;
+};
+
+class StaticArea
+{
+public:
+    StaticArea() noexcept = default;
+
+    StaticArea(void *b, void *e) noexcept
+            : mBegin(b), mEnd(e)
+    {
+    }
+
+    ~StaticArea() noexcept = default;
+
+    StaticArea(const StaticArea &rhs) = default;
+
+    StaticArea &operator=(const StaticArea &rhs) = default;
+
+    StaticArea(StaticArea &&rhs) noexcept = default;
+
+    StaticArea &operator=(StaticArea &&rhs) noexcept = default;
 
 public:
     void *data() const noexcept
@@ -547,107 +3015,453 @@ public:
     void *end() const noexcept
     { return mEnd; }
 
-    size_t size() const noexcept
-    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+    size_t size() const noexcept
+    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+
+    friend void swap(StaticArea &lhs, StaticArea &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mBegin, rhs.mBegin);
+        swap(lhs.mEnd, rhs.mEnd);
+    }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+};
+
+class NullArea
+{
+public:
+    void *data() const noexcept
+    { return nullptr; }
+
+    size_t size() const noexcept
+    { return 0; }
+};
+
+// ------------------------------------------------------------------------------------------------
+// Policies
+// ------------------------------------------------------------------------------------------------
+
+#define GX_ADAPTIVE_LOCK_FUTEX (GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID)
+
+/**
+ * @brief Contention counters of an AdaptiveLock.
+ */
+struct LockStats
+{
+    /// Successful lock() / try_lock() calls
+    uint64_t acquireCount = 0;
+    /// lock() calls that found the lock taken
+    uint64_t contendedCount = 0;
+    /// Contended lock() calls that got the lock while spinning
+    uint64_t spinAcquireCount = 0;
+    /// Times a thread went to sleep waiting for the lock
+    uint64_t parkCount = 0;
+};
+
+/**
+ * @class AdaptiveLock
+ * @brief Lock for short critical sections that may be oversubscribed.
+ * An uncontended lock() / unlock() is a single atomic operation each. A contended lock() first spins
+ * with a cpu pause (then yield), the spin length adapts to how long acquiring took before,
+ * then the thread parks on a futex (Linux / Android) or on a mutex and condition variable elsewhere,
+ * so waiters do not burn the cpu of a preempted owner.
+ * Contention counters are available through stats().
+ */
+class GX_API AdaptiveLock
+{
+public:
+    AdaptiveLock() noexcept = default;
+
+    AdaptiveLock(const AdaptiveLock &) = delete;
+
+    AdaptiveLock &operator=(const AdaptiveLock &) = delete;
+
+public:
+    void lock() noexcept
+    {
+        uint32_t expected = UNLOCKED;
+        if (!mState.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            lockSlow();
+        }
+        countAcquire();
+    }
+
+    bool try_lock() noexcept
+    {
+        uint32_t expected = UNLOCKED;
+        if (mState.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            countAcquire();
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() noexcept
+    {
+        if (mState.exchange(UNLOCKED, std::memory_order_release) == LOCKED_WAITERS) {
+            unpark();
+        }
+    }
+
+    LockStats stats() const noexcept
+    {
+        LockStats stats;
+        stats.acquireCount = mAcquireCount.load(std::memory_order_relaxed);
+        stats.contendedCount = mContendedCount.load(std::memory_order_relaxed);
+        stats.spinAcquireCount = mSpinAcquireCount.load(std::memory_order_relaxed);
+        stats.parkCount = mParkCount.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /// Locks are not movable, Pond swaps them as a no-op
+    friend void swap(AdaptiveLock &, AdaptiveLock &) noexcept
+    {}
+
+private:
+    constexpr static uint32_t UNLOCKED = 0;
+    constexpr static uint32_t LOCKED = 1;
+    constexpr static uint32_t LOCKED_WAITERS = 2;
+
+    /// Only called with the lock held, a plain load / store is enough
+    void countAcquire() noexcept
+    {
+        mAcquireCount.store(mAcquireCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void lockSlow() noexcept;
+
+    void park() noexcept;
+
+    void unpark() noexcept;
+
+private:
+    std::atomic<uint32_t> mState{UNLOCKED};
+    std::atomic<uint32_t> mSpinEstimate{0};
+    std::atomic<uint64_t> mAcquireCount{0};
+    std::atomic<uint64_t> mContendedCount{0};
+    std::atomic<uint64_t> mSpinAcquireCount{0};
+    std::atomic<uint64_t> mParkCount{0};
+#if !GX_ADAPTIVE_LOCK_FUTEX
+    std::mutex mParkMutex;
+    std::condition_variable mParkCond;
+#endif
+};
+
+
+namespace LockingPolicy
+{
+
+using NoLock = gx::GNoLock;
+
+using Mutex = gx::GMutex;
+
+using SpinLock = gx::GSpinLock;
+
+using Adaptive = gx::AdaptiveLock;
+
+} // namespace LockingPolicy
+
+
+/**
+ * @brief Snapshot of the statistics of a pond (TrackingPolicy::Stats).
+ */
+struct PondStats
+{
+    constexpr static size_t HISTOGRAM_SIZE = 16;
+
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;
+    uint64_t allocCount = 0;
+    uint64_t freeCount = 0;
+    uint64_t failedCount = 0;
+
+    /// Allocation count by requested size: bucket i holds sizes <= 16 << i, the last bucket holds the rest
+    uint64_t histogram[HISTOGRAM_SIZE] = {};
+
+    uint64_t outstanding() const noexcept
+    { return allocCount - freeCount; }
+};
+
+namespace TrackingPolicy
+{
+
+/**
+ * @brief No tracking, no overhead.
+ */
+class Untracked
+{
+public:
+    explicit Untracked(const char *) noexcept
+    {}
+
+    void onAlloc(void *, size_t) noexcept
+    {}
+
+    void onFree(void *, size_t) noexcept
+    {}
+
+    void onAllocBatch(size_t, size_t, size_t) noexcept
+    {}
+
+    void onFreeBatch(size_t, size_t) noexcept
+    {}
+
+    void onReset(size_t) noexcept
+    {}
+
+    friend void swap(Untracked &, Untracked &) noexcept
+    {}
+};
+
+/**
+ * @brief O(1) counters: current and peak bytes, allocation / free / failure counts and a size histogram.
+ * Every tracked pond is registered by name, use Stats::get(name) to read them from anywhere,
+ * ponds sharing a name are summed.
+ * Outstanding allocations are reported when the pond is destroyed.
+ * Sizes are the element size for fixed size allocators (PoolAllocator, DynamicPoolAllocator),
+ * otherwise the requested size, so Pond::free(p) without a size only releases bytes for fixed size allocators.
+ */
+class GX_API Stats
+{
+public:
+    explicit Stats(const char *name);
+
+    ~Stats();
+
+    Stats(const Stats &) = delete;
+
+    Stats &operator=(const Stats &) = delete;
+
+public:
+    void onAlloc(void *p, size_t size) noexcept
+    {
+        if (!p) {
+            mFailedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        mAllocCount.fetch_add(1, std::memory_order_relaxed);
+        mHistogram[histogramIndex(size)].fetch_add(1, std::memory_order_relaxed);
+        const uint64_t current = mCurrentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        uint64_t peak = mPeakBytes.load(std::memory_order_relaxed);
+        while (current > peak && !mPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onFree(void *, size_t size) noexcept
+    {
+        mFreeCount.fetch_add(1, std::memory_order_relaxed);
+        mCurrentBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Record count allocations of size bytes and failed failures, each counter is updated once.
+     */
+    void onAllocBatch(size_t count, size_t failed, size_t size) noexcept
+    {
+        if (failed) {
+            mFailedCount.fetch_add(failed, std::memory_order_relaxed);
+        }
+        if (count == 0) {
+            return;
+        }
+        mAllocCount.fetch_add(count, std::memory_order_relaxed);
+        mHistogram[histogramIndex(size)].fetch_add(count, std::memory_order_relaxed);
+        const uint64_t bytes = (uint64_t) count * size;
+        const uint64_t current = mCurrentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        uint64_t peak = mPeakBytes.load(std::memory_order_relaxed);
+        while (current > peak && !mPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onFreeBatch(size_t count, size_t size) noexcept
+    {
+        mFreeCount.fetch_add(count, std::memory_order_relaxed);
+        mCurrentBytes.fetch_sub((uint64_t) count * size, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Called after reset() / rewind(), the allocator reports how many bytes are still in use.
+     * @param remaining
+     */
+    void onReset(size_t remaining) noexcept
+    {
+        mCurrentBytes.store(remaining, std::memory_order_relaxed);
+        if (remaining == 0) {
+            mFreeCount.store(mAllocCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    const char *getName() const noexcept
+    { return mName; }
+
+    PondStats snapshot() const noexcept;
+
+    friend GX_API void swap(Stats &lhs, Stats &rhs) noexcept;
+
+public:
+    /**
+     * @brief Get the statistics of the tracked ponds with the given name.
+     * @param name
+     * @param out
+     * @return false if no tracked pond has this name
+     */
+    static bool get(const char *name, PondStats &out);
+
+    /**
+     * @brief Visit the statistics of every tracked pond.
+     * @param visitor
+     */
+    static void forEach(const std::function<void(const char *name, const PondStats &stats)> &visitor);
 
-    friend void swap(HeapArea &lhs, HeapArea &rhs) noexcept
+private:
+    static size_t histogramIndex(size_t size) noexcept
     {
-        using std::swap;
-        swap(lhs.mBegin, rhs.mBegin);
-        swap(lhs.mEnd, rhs.mEnd);
+        size_t index = 0;
+        size_t bound = 16;
+        while (size > bound && index < PondStats::HISTOGRAM_SIZE - 1) {
+            bound <<= 1;
+            ++index;
+        }
+        return index;
     }
 
 private:
-    void *mBegin = nullptr;
-    void *mEnd = nullptr;
+    const char *mName;
+    std::atomic<uint64_t> mCurrentBytes{0};
+    std::atomic<uint64_t> mPeakBytes{0};
+    std::atomic<uint64_t> mAllocCount{0};
+    std::atomic<uint64_t> mFreeCount{0};
+    std::atomic<uint64_t> mFailedCount{0};
+    std::atomic<uint64_t> mHistogram[PondStats::HISTOGRAM_SIZE]{};
 };
 
-class StaticArea
-{
-public:
-    StaticArea() noexcept = default;
-
-    StaticArea(void *b, void *e) noexcept
-            : mBegin(b), mEnd(e)
-    {
-    }
-
-    ~StaticArea() noexcept = default;
+} // namespace TrackingPolicy
 
-    StaticArea(const StaticArea &rhs) = default;
 
-    StaticArea &operator=(const StaticArea &rhs) = default;
+// ------------------------------------------------------------------------------------------------
+// Ponds
+// ------------------------------------------------------------------------------------------------
 
-    StaticArea(StaticArea &&rhs) noexcept = default;
+using UniquePtrDeleter = std::function<void(void *)>;
 
-    StaticArea &operator=(StaticArea &&rhs) noexcept = default;
+template<typename T>
+using UniquePtr = std::unique_ptr<T, UniquePtrDeleter>;
 
+/**
+ * @class PondDeleter
+ * @brief unique_ptr deleter holding only the pond pointer, see Pond::makeUnique().
+ * Converts to UniquePtrDeleter, so a PondUniquePtr can still be moved into a UniquePtr.
+ */
+template<typename T, typename POND>
+class PondDeleter
+{
 public:
-    void *data() const noexcept
-    { return mBegin; }
-
-    void *begin() const noexcept
-    { return mBegin; }
-
-    void *end() const noexcept
-    { return mEnd; }
+    PondDeleter() noexcept = default;
 
-    size_t size() const noexcept
-    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+    explicit PondDeleter(POND *pond) noexcept
+            : mPond(pond)
+    {}
 
-    friend void swap(StaticArea &lhs, StaticArea &rhs) noexcept
+    void operator()(void *p) const noexcept
     {
-        using std::swap;
-        swap(lhs.mBegin, rhs.mBegin);
-        swap(lhs.mEnd, rhs.mEnd);
+        mPond->destroy(static_cast<T *>(p));
     }
 
+    POND *getPond() const noexcept
+    { return mPond; }
+
 private:
-    void *mBegin = nullptr;
-    void *mEnd = nullptr;
+    POND *mPond = nullptr;
 };
 
-class NullArea
+template<typename T, typename POND>
+using PondUniquePtr = std::unique_ptr<T, PondDeleter<T, POND>>;
+
+namespace details
+{
+
+/**
+ * @brief Allocator given to std::allocate_shared() by Pond::makeShared(),
+ * every rebound type is aligned to at least ALIGN, failure throws as the Allocator requirements say.
+ */
+template<typename T, typename POND, size_t ALIGN>
+class PondSharedAllocator
 {
 public:
-    void *data() const noexcept
-    { return nullptr; }
+    using value_type = T;
 
-    size_t size() const noexcept
-    { return 0; }
-};
+    template<typename U>
+    struct rebind
+    {
+        using other = PondSharedAllocator<U, POND, ALIGN>;
+    };
 
-// ------------------------------------------------------------------------------------------------
-// Policies
-// ------------------------------------------------------------------------------------------------
+    explicit PondSharedAllocator(POND &pond) noexcept
+            : mPond(&pond)
+    {}
 
-namespace LockingPolicy
-{
+    template<typename U>
+    PondSharedAllocator(const PondSharedAllocator<U, POND, ALIGN> &rhs) noexcept // NOLINT
+            : mPond(rhs.mPond)
+    {}
 
-using NoLock = gx::GNoLock;
+    T *allocate(size_t n)
+    {
+        void *const p = mPond->alloc(n * sizeof(T), std::max(alignof(T), ALIGN));
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(p);
+    }
 
-using Mutex = gx::GMutex;
+    void deallocate(T *p, size_t n) noexcept
+    {
+        mPond->free(p, n * sizeof(T));
+    }
 
-using SpinLock = gx::GSpinLock;
+    template<typename U>
+    bool operator==(const PondSharedAllocator<U, POND, ALIGN> &rhs) const noexcept
+    {
+        return mPond == rhs.mPond;
+    }
 
-} // namespace LockingPolicy
+    template<typename U>
+    bool operator!=(const PondSharedAllocator<U, POND, ALIGN> &rhs) const noexcept
+    {
+        return mPond != rhs.mPond;
+    }
 
+private:
+    template<typename U, typename P, size_t A>
+    friend
+    class PondSharedAllocator;
 
-// ------------------------------------------------------------------------------------------------
-// Ponds
-// ------------------------------------------------------------------------------------------------
+    POND *mPond;
+};
 
-using UniquePtrDeleter = std::function<void(void *)>;
+template<typename A, typename = void>
+struct HasElementSize : std::false_type
+{
+};
 
-template<typename T>
-using UniquePtr = std::unique_ptr<T, UniquePtrDeleter>;
+template<typename A>
+struct HasElementSize<A, std::void_t<decltype(std::declval<const A &>().elementSize())>> : std::true_type
+{
+};
+
+} // namespace details
 
-template<typename AllocatorPolicy, typename LockingPolicy, typename AreaPolicy = HeapArea>
+template<typename AllocatorPolicy, typename LockingPolicy, typename AreaPolicy = HeapArea,
+        typename TrackingPolicy = gx::TrackingPolicy::Untracked>
 class Pond
 {
 public:
     explicit Pond(const char *name = "")
-            : mName(name)
+            : mName(name),
+              mTracking(name)
     {
     }
 
@@ -662,7 +3476,8 @@ public:
     Pond(const char *name, size_t size, ARGS &&... args)
             : mArea(size),
               mAllocator(mArea, std::forward<ARGS>(args) ...),
-              mName(name)
+              mName(name),
+              mTracking(name)
     {
     }
 
@@ -670,7 +3485,8 @@ public:
     Pond(const char *name, AreaPolicy &&area, ARGS &&... args)
             : mArea(std::forward<AreaPolicy>(area)),
               mAllocator(mArea, std::forward<ARGS>(args) ...),
-              mName(name)
+              mName(name),
+              mTracking(name)
     {
     }
 
@@ -699,6 +3515,7 @@ public:
     {
         GLockerGuard guard(mLock);
         void *p = mAllocator.alloc(size, alignment, extra);
+        mTracking.onAlloc(p, trackedSize(size));
         return p;
     }
 
@@ -728,6 +3545,7 @@ public:
         if (p) {
             GLockerGuard guard(mLock);
             mAllocator.free(p);
+            mTracking.onFree(p, trackedSize(0));
         }
     }
 
@@ -741,6 +3559,35 @@ public:
         if (p) {
             GLockerGuard guard(mLock);
             mAllocator.free(p, size);
+            mTracking.onFree(p, trackedSize(size));
+        }
+    }
+
+    /**
+     * @brief Allocate up to n elements under a single lock, for fixed size allocators (PoolAllocator, DynamicPoolAllocator).
+     * @param out
+     * @param n
+     * @return Number of elements allocated
+     */
+    size_t allocBatch(void **out, size_t n) noexcept
+    {
+        GLockerGuard guard(mLock);
+        const size_t count = mAllocator.allocBatch(out, n);
+        mTracking.onAllocBatch(count, n - count, mAllocator.elementSize());
+        return count;
+    }
+
+    /**
+     * @brief Release n elements under a single lock.
+     * @param in
+     * @param n
+     */
+    void freeBatch(void *const *in, size_t n) noexcept
+    {
+        if (n) {
+            GLockerGuard guard(mLock);
+            mAllocator.freeBatch(in, n);
+            mTracking.onFreeBatch(n, mAllocator.elementSize());
         }
     }
 
@@ -754,6 +3601,7 @@ public:
     {
         GLockerGuard guard(mLock);
         mAllocator.reset();
+        mTracking.onReset(mAllocator.size());
     }
 
     void *getCurrent() noexcept
@@ -763,6 +3611,7 @@ public:
     {
         GLockerGuard guard(mLock);
         mAllocator.rewind(addr);
+        mTracking.onReset(mAllocator.size());
     }
 
     size_t size() const noexcept
@@ -777,6 +3626,19 @@ public:
         return mAllocator.capacity();
     }
 
+    /**
+     * @brief Call func(allocator) while holding the pond lock,
+     * for allocator specific operations that Pond does not forward, e.g. PoolAllocator::purge().
+     * @param func
+     * @return Result of func
+     */
+    template<typename FUNC>
+    decltype(auto) lockedCall(FUNC &&func)
+    {
+        GLockerGuard guard(mLock);
+        return func(mAllocator);
+    }
+
     /**
      * @class Assign and construct an object.
      * @tparam T
@@ -809,6 +3671,9 @@ public:
     /**
      * @brief Allocate memory for the specified type and create an object and return shared_ Ptr,
      * the object will automatically destruct and reclaim memory after the reference count is reset to zero.
+     * The object and the control block share one allocation from this pond (std::allocate_shared).
+     * Fixed size allocators whose element cannot hold both only get the object,
+     * the control block then comes from the heap, use SharedPtrPoolAllocator<T> to avoid it.
      * @tparam T
      * @tparam ALIGN
      * @tparam ARGS
@@ -818,18 +3683,32 @@ public:
     template<typename T, size_t ALIGN = alignof(T), typename... ARGS>
     std::shared_ptr<T> makeShared(ARGS &&... args) noexcept
     {
-        void *const p = this->alloc(sizeof(T), ALIGN);
-        if (p) {
-            return std::shared_ptr<T>(new(p) T(std::forward<ARGS>(args)...), [this](void *ptr) {
-                destroy(static_cast<T *>(ptr));
-            });
+        if constexpr (details::HasElementSize<AllocatorPolicy>::value) {
+            if (mAllocator.elementSize() < details::sharedPtrBlockSize<T>()) {
+                T *const p = make<T, ALIGN>(std::forward<ARGS>(args)...);
+                if (p == nullptr) {
+                    return nullptr;
+                }
+                try {
+                    return std::shared_ptr<T>(p, PondDeleter<T, Pond>(this));
+                } catch (const std::bad_alloc &) {
+                    // The deleter has already destroyed p
+                    return nullptr;
+                }
+            }
+        }
+        try {
+            return std::allocate_shared<T>(details::PondSharedAllocator<T, Pond, ALIGN>(*this),
+                                           std::forward<ARGS>(args)...);
+        } catch (const std::bad_alloc &) {
+            return nullptr;
         }
-        return nullptr;
     }
 
     /**
      * @brief Allocate memory for the specified type and create an object and return unique_ Ptr,
      * the object will automatically destruct and reclaim memory after being abandoned by the owner.
+     * The deleter only holds this pond's address, the result converts to UniquePtr<T> when needed.
      * @tparam T
      * @tparam ALIGN
      * @tparam ARGS
@@ -837,14 +3716,11 @@ public:
      * @return
      */
     template<typename T, size_t ALIGN = alignof(T), typename... ARGS>
-    UniquePtr<T> makeUnique(ARGS &&... args) noexcept
+    PondUniquePtr<T, Pond> makeUnique(ARGS &&... args) noexcept
     {
         void *const p = this->alloc(sizeof(T), ALIGN);
         if (p) {
-            UniquePtrDeleter deleter = [this](void *ptr) {
-                destroy(static_cast<T *>(ptr));
-            };
-            return std::unique_ptr<T, UniquePtrDeleter>(new(p) T(std::forward<ARGS>(args)...), deleter);
+            return PondUniquePtr<T, Pond>(new(p) T(std::forward<ARGS>(args)...), PondDeleter<T, Pond>(this));
         }
         return nullptr;
     }
@@ -864,6 +3740,12 @@ public:
     const AreaPolicy &getArea() const noexcept
     { return mArea; }
 
+    const TrackingPolicy &getTracking() const noexcept
+    { return mTracking; }
+
+    const LockingPolicy &getLock() const noexcept
+    { return mLock; }
+
     friend void swap(Pond &lhs, Pond &rhs) noexcept
     {
         using std::swap;
@@ -871,6 +3753,18 @@ public:
         swap(lhs.mAllocator, rhs.mAllocator);
         swap(lhs.mLock, rhs.mLock);
         swap(lhs.mName, rhs.mName);
+        swap(lhs.mTracking, rhs.mTracking);
+    }
+
+private:
+    /// Fixed size allocators always consume one element, whatever the requested size
+    size_t trackedSize(size_t size) const noexcept
+    {
+        if constexpr (details::HasElementSize<AllocatorPolicy>::value) {
+            return mAllocator.elementSize();
+        } else {
+            return size;
+        }
     }
 
 private:
@@ -878,12 +3772,67 @@ private:
     AllocatorPolicy mAllocator;
     mutable LockingPolicy mLock;
     const char *mName = nullptr;
+    TrackingPolicy mTracking;
 };
 
 // ------------------------------------------------------------------------------------------------
 
 using HeapPond = Pond<HeapAllocator, LockingPolicy::NoLock>;
 
+/**
+ * @class NumaPondSelector
+ * @brief One pond per NUMA node, local() picks the pond of the node the calling thread runs on.
+ * Memory must be freed to the pond it came from (see get()), not to the local one.
+ * With a single node there is exactly one pond and local() does not query the CPU.
+ * @tparam POND
+ */
+template<typename POND>
+class NumaPondSelector
+{
+public:
+    /**
+     * @param factory std::unique_ptr<POND>(uint32_t node), e.g. a Pond over a NumaArea of that node
+     */
+    template<typename FACTORY>
+    explicit NumaPondSelector(FACTORY &&factory)
+    {
+        const uint32_t count = numa::nodeCount();
+        mPonds.reserve(count);
+        for (uint32_t node = 0; node < count; node++) {
+            mPonds.push_back(factory(node));
+        }
+    }
+
+    NumaPondSelector(const NumaPondSelector &) = delete;
+
+    NumaPondSelector &operator=(const NumaPondSelector &) = delete;
+
+public:
+    POND &local() noexcept
+    {
+        return *mPonds[localIndex()];
+    }
+
+    POND &get(uint32_t node) noexcept
+    {
+        GX_ASSERT(node < mPonds.size());
+        return *mPonds[node];
+    }
+
+    uint32_t localIndex() const noexcept
+    {
+        return mPonds.size() == 1 ? 0 : numa::currentNode() % (uint32_t) mPonds.size();
+    }
+
+    uint32_t nodeCount() const noexcept
+    {
+        return (uint32_t) mPonds.size();
+    }
+
+private:
+    std::vector<std::unique_ptr<POND>> mPonds;
+};
+
 
 /**
  * Splitter packaging that can be used with STL container translators
@@ -952,6 +3901,180 @@ private:
     POND &mPond;
 };
 
+#if GX_HAS_MEMORY_RESOURCE
+
+/**
+ * @class PondResource
+ * @brief std::pmr::memory_resource over any Pond, so that pond backed std::pmr containers
+ * share the standard container types.
+ * The pond must outlive the resource, allocation failure throws std::bad_alloc as memory_resource requires.
+ * @tparam POND
+ */
+template<typename POND>
+class PondResource : public std::pmr::memory_resource
+{
+public:
+    explicit PondResource(POND &pond) noexcept
+            : mPond(pond)
+    {}
+
+    POND &getPond() noexcept
+    { return mPond; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        void *const p = mPond.alloc(bytes, alignment);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t) override
+    {
+        mPond.free(p, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    POND &mPond;
+};
+
+/**
+ * @class LinearPondResource
+ * @brief memory_resource owning a LinearAllocator pond (arena).
+ * Deallocation is a no-op, release() frees everything at once,
+ * allocations that do not fit the arena go to the upstream resource.
+ * @tparam LOCKING_POLICY
+ */
+template<typename LOCKING_POLICY = LockingPolicy::NoLock>
+class LinearPondResource : public std::pmr::memory_resource
+{
+public:
+    using PondType = Pond<LinearAllocator, LOCKING_POLICY>;
+
+public:
+    explicit LinearPondResource(size_t size,
+                                std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+            : mPond("LinearPondResource", size),
+              mUpstream(upstream)
+    {}
+
+    /**
+     * @brief Rewind the arena, everything allocated from it becomes invalid.
+     */
+    void release() noexcept
+    { mPond.reset(); }
+
+    PondType &getPond() noexcept
+    { return mPond; }
+
+    std::pmr::memory_resource *upstreamResource() const noexcept
+    { return mUpstream; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        void *const p = mPond.alloc(bytes, alignment);
+        return p ? p : mUpstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        if (p < mPond.getArea().begin() || p >= mPond.getArea().end()) {
+            mUpstream->deallocate(p, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    PondType mPond;
+    std::pmr::memory_resource *mUpstream;
+};
+
+/**
+ * @class PoolPondResource
+ * @brief memory_resource owning a PoolAllocator pond, for node based containers
+ * (std::pmr::list, map, unordered_map nodes...).
+ * Requests that fit ELEMENT_SIZE and ALIGNMENT come from the pool, larger ones (e.g. bucket arrays)
+ * go to the upstream resource.
+ * @tparam ELEMENT_SIZE
+ * @tparam ALIGNMENT
+ * @tparam LOCKING_POLICY
+ */
+template<size_t ELEMENT_SIZE, size_t ALIGNMENT = alignof(std::max_align_t),
+        typename LOCKING_POLICY = LockingPolicy::NoLock>
+class PoolPondResource : public std::pmr::memory_resource
+{
+public:
+    using PondType = Pond<PoolAllocator<ELEMENT_SIZE, ALIGNMENT>, LOCKING_POLICY>;
+
+public:
+    /**
+     * @param preAllocSize Bytes preallocated for the pool, it grows from the heap when exhausted
+     * @param upstream
+     */
+    explicit PoolPondResource(size_t preAllocSize = 0,
+                              std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+            : mPond("PoolPondResource", preAllocSize),
+              mUpstream(upstream)
+    {}
+
+    PondType &getPond() noexcept
+    { return mPond; }
+
+    std::pmr::memory_resource *upstreamResource() const noexcept
+    { return mUpstream; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (!fits(bytes, alignment)) {
+            return mUpstream->allocate(bytes, alignment);
+        }
+        void *const p = mPond.alloc(ELEMENT_SIZE, ALIGNMENT);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        if (fits(bytes, alignment)) {
+            mPond.free(p);
+        } else {
+            mUpstream->deallocate(p, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    static bool fits(size_t bytes, size_t alignment) noexcept
+    {
+        return bytes <= ELEMENT_SIZE && alignment <= ALIGNMENT;
+    }
+
+private:
+    PondType mPond;
+    std::pmr::memory_resource *mUpstream;
+};
+
+#endif
+
 GX_NS_END
 
 #endif //GX_ALLOCATOR_H
@@ -373,7 +373,11 @@ private:
         uint8_t *buffer = nullptr;
         uint32_t size = 0;
 
-        explicit BufferRef(uint32_t size);
+        /**
+         * @param size
+         * @param uninitialized Leading bytes the caller overwrites, only the rest is zero-filled
+         */
+        explicit BufferRef(uint32_t size, uint32_t uninitialized = 0);
         ~BufferRef();
 
         void resize(uint32_t newSize);
@@ -25,21 +25,50 @@
 
 #include "allocator.h"
 
+#include <memory>
+#include <vector>
+
 
 GX_NS_BEGIN
 
+class GTimer;
+
+class GTimerScheduler;
+
 /**
  * @class GGlobalMemoryPool
  * @brief Global memory pool, a memory pool provided by GByteArray.
+ * Requests up to 64K are rounded up to one of the size classes (16B, 24B, 32B, 48B, 64B ... 48K, 64K,
+ * two classes per power of two), each class is served by its own pool, larger requests go to the heap.
+ * Each thread keeps a small cache (magazine) of free blocks in front of the shared pools,
+ * so that the common alloc/free path does not take the pool lock.
+ * trim() and gc() rebalance the caches: every thread returns its cached blocks to the shared pools
+ * on its next alloc or free.
+ * Free blocks that stay unused are given back to the system by trim(), which can run periodically on a GTimer.
  */
 class GX_API GGlobalMemoryPool
 {
-    constexpr static uint32_t ELEMENT_S_SIZE = 8 * 1024;
-    constexpr static uint32_t ELEMENT_M_SIZE = 64 * 1024;
+public:
+    constexpr static uint32_t MIN_CLASS_SIZE = 16;
+    constexpr static uint32_t MAX_CLASS_SIZE = 64 * 1024;
+    constexpr static uint32_t SIZE_CLASS_COUNT = 25;
 
 public:
+    /**
+     * @brief Allocate a zero-filled block.
+     * @param size Requested size, rounded up to the size actually allocated
+     */
     static void *alloc(uint32_t &size);
 
+    /**
+     * @brief Same as alloc(), but the content is left uninitialized,
+     * for callers that overwrite the whole block anyway.
+     * With GX_MEMORY_POOL_POISON (default in debug builds) the block is filled with 0xCD instead,
+     * so that reads of uninitialized data are easy to spot.
+     * @param size Requested size, rounded up to the size actually allocated
+     */
+    static void *allocUninitialized(uint32_t &size);
+
     static void free(void *ptr, uint32_t size);
 
     static void gc();
@@ -50,6 +79,36 @@ public:
 
     static uint64_t poolSize();
 
+    /**
+     * @brief Contention counters of the size class locks, summed over all classes.
+     */
+    static LockStats lockStats();
+
+    /**
+     * @brief Configure trim().
+     * @param decayMs Interval of the automatic trim, blocks that stay free for a whole interval are released
+     * @param lowWatermark Free bytes the pool always keeps
+     * @param highWatermark Above this many free bytes, trim() releases down to lowWatermark regardless of age
+     */
+    static void setTrimPolicy(int64_t decayMs, uint64_t lowWatermark, uint64_t highWatermark);
+
+    /**
+     * @brief Give free blocks that were not used since the previous trim() back to the system.
+     * The whole pages inside free blocks are decommitted (madvise(MADV_DONTNEED)), the blocks and their
+     * slabs stay allocated, so only size classes of two pages or more give memory back.
+     * Thread caches are asked to flush, their blocks are released by a following trim().
+     * @return Bytes of pages decommitted
+     */
+    static uint64_t trim();
+
+    /**
+     * @brief Run trim() every decayMs on a timer.
+     * @param scheduler Scheduler of the timer, the global scheduler when nullptr
+     */
+    static void startAutoTrim(const std::shared_ptr<GTimerScheduler> &scheduler = nullptr);
+
+    static void stopAutoTrim();
+
 public:
     GGlobalMemoryPool(const GGlobalMemoryPool &) = delete;
 
@@ -64,7 +123,7 @@ private:
 
     static GGlobalMemoryPool *getInstance();
 
-    void *_alloc(uint32_t &size);
+    void *_alloc(uint32_t &size, bool zeroFill);
 
     void _free(void *ptr, uint32_t size);
 
@@ -76,16 +135,46 @@ private:
 
     uint64_t _poolSize();
 
+    LockStats _lockStats();
+
+    void _setTrimPolicy(int64_t decayMs, uint64_t lowWatermark, uint64_t highWatermark);
+
+    uint64_t _trim();
+
+    void _startAutoTrim(const std::shared_ptr<GTimerScheduler> &scheduler);
+
+    void _stopAutoTrim();
+
+private:
+    struct ThreadCache;
+
+    ThreadCache *localCache();
+
+    void releaseCache(ThreadCache *cache);
+
+    static uint32_t sizeClassIndex(uint32_t size);
+
+    static uint32_t sizeClassSize(uint32_t index);
+
 private:
     using HeadPond = Pond<HeapAllocator, LockingPolicy::NoLock>;
-    using PoolPondA = Pond<PoolAllocator<ELEMENT_S_SIZE>, LockingPolicy::Mutex>;
-    using PoolPondB = Pond<PoolAllocator<ELEMENT_M_SIZE>, LockingPolicy::Mutex>;
+    using ClassPond = Pond<DynamicPoolAllocator, LockingPolicy::Adaptive>;
 
     HeadPond mHeapAlloc;
-    PoolPondA mPoolAllocS;
-    PoolPondB mPoolAllocM;
+    std::unique_ptr<ClassPond> mClassPonds[SIZE_CLASS_COUNT];
 
     std::atomic<uint64_t> mAllocatedSize{0};
+
+    GMutex mCacheLock;
+    std::vector<ThreadCache *> mThreadCaches;
+    /// Bumped to make every thread flush its cache
+    std::atomic<uint64_t> mFlushEpoch{0};
+
+    GMutex mTrimLock;
+    int64_t mTrimDecay;
+    uint64_t mTrimLowWatermark;
+    uint64_t mTrimHighWatermark;
+    std::shared_ptr<GTimer> mTrimTimer;
 };
 
 GX_NS_END
@@ -26,6 +26,7 @@
 #include "gbytearray.h"
 
 #include <memory>
+#include <memory.h>
 
 
 GX_NS_BEGIN
@@ -40,6 +41,22 @@ public:
     virtual void update(const uint8_t *data, uint32_t size) = 0;
 
     virtual GByteArray final() = 0;
+
+    /**
+     * @brief Write the digest into a caller buffer, without allocating.
+     * @param digest
+     * @param size Size of the buffer, at least GHashSum::digestSize()
+     * @return Bytes written, 0 if the buffer is too small
+     */
+    virtual uint32_t final(uint8_t *digest, uint32_t size)
+    {
+        const GByteArray result = final();
+        if (result.size() > size) {
+            return 0;
+        }
+        memcpy(digest, result.data(), result.size());
+        return result.size();
+    }
 };
 
 /**
@@ -56,8 +73,29 @@ public:
         Sha256 = 3,
     };
 
+    /// Largest digest of the supported types (Sha256)
+    constexpr static uint32_t MAX_DIGEST_SIZE = 32;
+
 public:
     static std::unique_ptr<GHashJob> hashSum(GHashSum::HashType hashType);
+
+    /**
+     * @brief Hash data in one call, the job lives on the stack and the digest goes to a caller buffer,
+     * so nothing is allocated.
+     * @param hashType
+     * @param data
+     * @param size
+     * @param digest
+     * @param digestSize Size of the buffer, at least digestSize(hashType)
+     * @return Bytes written, 0 for an unknown type or a buffer too small
+     */
+    static uint32_t hashSum(GHashSum::HashType hashType, const uint8_t *data, uint32_t size,
+                            uint8_t *digest, uint32_t digestSize);
+
+    /**
+     * @brief Size of the digest in bytes, 0 for an unknown type.
+     */
+    static uint32_t digestSize(GHashSum::HashType hashType);
 };
 
 GX_NS_END
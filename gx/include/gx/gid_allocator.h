@@ -29,6 +29,14 @@
 #include "gx/gmutex.h"
 
 #include <limits>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 
 GX_NS_BEGIN
@@ -83,7 +91,7 @@ public:
 
         ID_TYPE index = mSparse[id];
         --mNum;
-        uint16_t temp = mDense[mNum];
+        ID_TYPE temp = mDense[mNum];
         mDense[mNum] = id;
         mSparse[temp] = index;
         mDense[index] = temp;
@@ -94,7 +102,7 @@ public:
         if (id >= MaxNum) {
             return false;
         }
-        uint16_t index = mSparse[id];
+        ID_TYPE index = mSparse[id];
         return index < mNum && mDense[index] == id;
     }
 
@@ -107,5 +115,259 @@ private:
     MUTEX mMutex;
 };
 
+/**
+ * @brief Handle issued by GHandleAllocator: a slot index and the generation of the slot when it was issued.
+ */
+struct GHandle
+{
+    constexpr static uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = NULL_INDEX;
+    uint32_t generation = 0;
+
+    bool isNull() const noexcept
+    {
+        return index == NULL_INDEX;
+    }
+
+    /**
+     * @brief Pack into 64 bits, e.g. to store the handle in an atomic or pass it through a void*.
+     */
+    uint64_t value() const noexcept
+    {
+        return (uint64_t(generation) << 32) | index;
+    }
+
+    static GHandle fromValue(uint64_t value) noexcept
+    {
+        return GHandle{uint32_t(value), uint32_t(value >> 32)};
+    }
+
+    bool operator==(const GHandle &rhs) const noexcept
+    {
+        return index == rhs.index && generation == rhs.generation;
+    }
+
+    bool operator!=(const GHandle &rhs) const noexcept
+    {
+        return !(*this == rhs);
+    }
+};
+
+/**
+ * Generational handle allocator
+ * Each slot has a generation counter, odd while the slot is alive, incremented on alloc and on free,
+ * so a handle kept after its slot was freed (and maybe reused) no longer validates.
+ * Slots live in segments of doubling size that are never moved, capacity grows on demand.
+ * alloc(), free() and isValid() are lock-free, free slots form a stack with an ABA tag.
+ * reset() must not run concurrently with the other calls.
+ */
+class GHandleAllocator final
+{
+public:
+    constexpr static uint32_t FIRST_SEGMENT_SIZE = 64;
+    constexpr static uint32_t SEGMENT_COUNT = 26;
+
+public:
+    GHandleAllocator() = default;
+
+    ~GHandleAllocator()
+    {
+        for (auto &segment: mSegments) {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    GHandleAllocator(const GHandleAllocator &) = delete;
+
+    GHandleAllocator &operator=(const GHandleAllocator &) = delete;
+
+public:
+    /**
+     * @return A null handle when all 2^32 - 64 slots are in use
+     */
+    GHandle alloc()
+    {
+        uint32_t index = popFree();
+        if (index == GHandle::NULL_INDEX) {
+            // mNext stops at the limit, so that failed calls can neither overflow it nor wrap it around
+            index = mNext.load(std::memory_order_relaxed);
+            do {
+                if (index >= capacityLimit()) {
+                    return GHandle{};
+                }
+            } while (!mNext.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+            if (!ensureSegment(index)) {
+                return GHandle{};
+            }
+        }
+        Slot &s = slot(index);
+        // Only the thread that got the index writes it, the generation becomes odd (alive)
+        const uint32_t generation = s.generation.load(std::memory_order_relaxed) + 1;
+        s.generation.store(generation, std::memory_order_release);
+        mAliveCount.fetch_add(1, std::memory_order_relaxed);
+        return GHandle{index, generation};
+    }
+
+    /**
+     * @brief Release the slot of a live handle.
+     * @return false if the handle is stale, null or was already freed
+     */
+    bool free(GHandle handle)
+    {
+        if (!isValid(handle)) {
+            return false;
+        }
+        uint32_t generation = handle.generation;
+        if (!slot(handle.index).generation.compare_exchange_strong(generation, generation + 1,
+                                                                     std::memory_order_acq_rel)) {
+            return false;
+        }
+        mAliveCount.fetch_sub(1, std::memory_order_relaxed);
+        pushFree(handle.index);
+        return true;
+    }
+
+    bool isValid(GHandle handle) const
+    {
+        if (!(handle.generation & 1) || handle.index >= capacityLimit() ||
+            handle.index >= mNext.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const Slot *segment = mSegments[segmentOf(handle.index)].load(std::memory_order_acquire);
+        if (segment == nullptr) {
+            return false;
+        }
+        return segment[offsetOf(handle.index)].generation.load(std::memory_order_acquire) == handle.generation;
+    }
+
+    /**
+     * @brief Invalidate every handle, the slots are kept and reused from index 0.
+     */
+    void reset()
+    {
+        const uint32_t count = std::min(mNext.load(std::memory_order_relaxed), capacityLimit());
+        uint32_t head = GHandle::NULL_INDEX;
+        for (uint32_t i = count; i-- > 0;) {
+            Slot *segment = mSegments[segmentOf(i)].load(std::memory_order_relaxed);
+            if (segment == nullptr) {
+                continue;
+            }
+            Slot &s = segment[offsetOf(i)];
+            const uint32_t generation = s.generation.load(std::memory_order_relaxed);
+            s.generation.store(generation + (generation & 1), std::memory_order_relaxed);
+            s.nextFree.store(head, std::memory_order_relaxed);
+            head = i;
+        }
+        mFreeHead.store(makeHead(head, 0), std::memory_order_release);
+        mAliveCount.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of live handles.
+     */
+    uint32_t size() const
+    {
+        return mAliveCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of slots ever created.
+     */
+    uint32_t capacity() const
+    {
+        return std::min(mNext.load(std::memory_order_relaxed), capacityLimit());
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> generation;
+        std::atomic<uint32_t> nextFree;
+    };
+
+    constexpr static uint32_t capacityLimit()
+    {
+        return FIRST_SEGMENT_SIZE * ((1u << SEGMENT_COUNT) - 1);
+    }
+
+    /// Segment k holds FIRST_SEGMENT_SIZE << k slots
+    static uint32_t segmentOf(uint32_t index)
+    {
+        const uint32_t v = index / FIRST_SEGMENT_SIZE + 1;
+#if defined(_MSC_VER)
+        unsigned long k;
+        _BitScanReverse(&k, v);
+        return (uint32_t) k;
+#else
+        return 31 - (uint32_t) __builtin_clz(v);
+#endif
+    }
+
+    static uint32_t offsetOf(uint32_t index)
+    {
+        return index - FIRST_SEGMENT_SIZE * ((1u << segmentOf(index)) - 1);
+    }
+
+    Slot &slot(uint32_t index)
+    {
+        return mSegments[segmentOf(index)].load(std::memory_order_acquire)[offsetOf(index)];
+    }
+
+    bool ensureSegment(uint32_t index)
+    {
+        const uint32_t k = segmentOf(index);
+        if (mSegments[k].load(std::memory_order_acquire)) {
+            return true;
+        }
+        Slot *segment = new(std::nothrow) Slot[FIRST_SEGMENT_SIZE << k]();
+        if (segment == nullptr) {
+            return false;
+        }
+        Slot *expected = nullptr;
+        if (!mSegments[k].compare_exchange_strong(expected, segment, std::memory_order_acq_rel)) {
+            delete[] segment;
+        }
+        return true;
+    }
+
+    static uint64_t makeHead(uint32_t index, uint32_t tag)
+    {
+        return (uint64_t(tag) << 32) | index;
+    }
+
+    uint32_t popFree()
+    {
+        uint64_t head = mFreeHead.load(std::memory_order_acquire);
+        while (uint32_t(head) != GHandle::NULL_INDEX) {
+            // The slot may be popped by another thread meanwhile, the tag makes the CAS fail in that case
+            const uint32_t next = slot(uint32_t(head)).nextFree.load(std::memory_order_relaxed);
+            if (mFreeHead.compare_exchange_weak(head, makeHead(next, uint32_t(head >> 32) + 1),
+                                                std::memory_order_acquire, std::memory_order_acquire)) {
+                return uint32_t(head);
+            }
+        }
+        return GHandle::NULL_INDEX;
+    }
+
+    void pushFree(uint32_t index)
+    {
+        Slot &s = slot(index);
+        uint64_t head = mFreeHead.load(std::memory_order_relaxed);
+        do {
+            s.nextFree.store(uint32_t(head), std::memory_order_relaxed);
+        } while (!mFreeHead.compare_exchange_weak(head, makeHead(index, uint32_t(head >> 32) + 1),
+                                                  std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<Slot *> mSegments[SEGMENT_COUNT]{};
+    /// Top of the free slot stack (low 32 bits) and its ABA tag (high 32 bits)
+    std::atomic<uint64_t> mFreeHead{GHandle::NULL_INDEX};
+    /// Next never used index
+    std::atomic<uint32_t> mNext{0};
+    std::atomic<uint32_t> mAliveCount{0};
+};
+
 GX_NS_END
 #endif //GX_GIDALLOCATOR_H
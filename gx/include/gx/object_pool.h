@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GX_OBJECT_POOL_H
+#define GX_OBJECT_POOL_H
+
+#include "gx/base.h"
+#include "gx/gglobal.h"
+
+#include "memalign.h"
+#include "debug.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+GX_NS_BEGIN
+
+namespace details
+{
+
+static inline uint32_t lowestBit64(uint64_t v) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (uint32_t) index;
+#else
+    return (uint32_t) __builtin_ctzll(v);
+#endif
+}
+
+constexpr size_t nextPowerOfTwo(size_t v) noexcept
+{
+    size_t p = 1;
+    while (p < v) {
+        p <<= 1;
+    }
+    return p;
+}
+
+}
+
+/**
+ * @class ObjectPool
+ * @brief Typed pool that knows which of its objects are alive.
+ * Objects are stored contiguously in slabs aligned to their (power of two) size,
+ * each slab has an occupancy bitmap, so forEach() sweeps the live objects in memory order
+ * and destroy() finds the slab of an object by masking its address.
+ * New objects take the lowest free slot of a slab, keeping the live objects packed.
+ * Not thread safe.
+ * @tparam T
+ * @tparam SLAB_SIZE Minimum slab size in bytes, grown to hold at least 8 objects
+ */
+template<typename T, size_t SLAB_SIZE = 16 * 1024>
+class ObjectPool
+{
+public:
+    constexpr static size_t CACHE_LINE_SIZE = 64;
+
+private:
+    static_assert(!(SLAB_SIZE & (SLAB_SIZE - 1)), "SLAB_SIZE must be a power of two");
+
+    constexpr static size_t OBJECT_ALIGNMENT = std::max(alignof(T), CACHE_LINE_SIZE);
+    constexpr static size_t SLAB_BYTES = std::max(SLAB_SIZE, details::nextPowerOfTwo(
+            OBJECT_ALIGNMENT * 2 + sizeof(T) * 8));
+
+    struct Slab;
+
+    struct SlabInfo
+    {
+        Slab *nextPartial;
+        uint32_t liveCount;
+        bool partial;
+    };
+
+    /// The bitmap is sized for an upper bound of the slot count, the header is rounded up to OBJECT_ALIGNMENT
+    constexpr static size_t MAX_SLOT_COUNT = (SLAB_BYTES - sizeof(SlabInfo)) / sizeof(T);
+    constexpr static size_t BITMAP_WORDS = (MAX_SLOT_COUNT + 63) / 64;
+    constexpr static size_t HEADER_SIZE = (sizeof(SlabInfo) + BITMAP_WORDS * sizeof(uint64_t) + OBJECT_ALIGNMENT - 1)
+                                          & ~(OBJECT_ALIGNMENT - 1);
+
+public:
+    constexpr static size_t SLOT_COUNT = (SLAB_BYTES - HEADER_SIZE) / sizeof(T);
+
+private:
+    static_assert(SLOT_COUNT >= 1 && SLOT_COUNT <= MAX_SLOT_COUNT, "ObjectPool: invalid slab layout");
+
+    struct Slab
+    {
+        SlabInfo info;
+        uint64_t live[BITMAP_WORDS];
+
+        T *objects() noexcept
+        {
+            return reinterpret_cast<T *>(reinterpret_cast<uint8_t *>(this) + HEADER_SIZE);
+        }
+    };
+
+public:
+    ObjectPool() noexcept = default;
+
+    ~ObjectPool()
+    {
+        clear();
+        for (Slab *slab: mSlabs) {
+            alignedFree(slab);
+        }
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    ObjectPool(ObjectPool &&rhs) noexcept
+    {
+        swap(*this, rhs);
+    }
+
+    ObjectPool &operator=(ObjectPool &&rhs) noexcept
+    {
+        swap(*this, rhs);
+        return *this;
+    }
+
+public:
+    /**
+     * @brief Construct an object in the lowest free slot.
+     * @tparam ARGS
+     * @param args
+     * @return nullptr if a new slab cannot be allocated
+     */
+    template<typename... ARGS>
+    T *make(ARGS &&... args)
+    {
+        Slab *slab = mPartial;
+        if (slab == nullptr) {
+            slab = createSlab();
+            if (slab == nullptr) {
+                return nullptr;
+            }
+        }
+        const size_t index = lowestFreeSlot(slab);
+        T *const p = new(slab->objects() + index) T(std::forward<ARGS>(args)...);
+
+        slab->live[index / 64] |= uint64_t(1) << (index % 64);
+        if (++slab->info.liveCount == SLOT_COUNT) {
+            mPartial = slab->info.nextPartial;
+            slab->info.partial = false;
+        }
+        ++mSize;
+        return p;
+    }
+
+    /**
+     * @brief Destruct an object made by this pool, its slot is reused by the next make().
+     * @param p
+     */
+    void destroy(T *p) noexcept
+    {
+        if (p == nullptr) {
+            return;
+        }
+        Slab *const slab = slabOf(p);
+        const size_t index = size_t(p - slab->objects());
+        uint64_t &word = slab->live[index / 64];
+        const uint64_t bit = uint64_t(1) << (index % 64);
+        GX_ASSERT_S(word & bit, "ObjectPool::destroy: object is not alive");
+
+        p->~T();
+        word &= ~bit;
+        --slab->info.liveCount;
+        if (!slab->info.partial) {
+            slab->info.nextPartial = mPartial;
+            slab->info.partial = true;
+            mPartial = slab;
+        }
+        --mSize;
+    }
+
+    /**
+     * @brief Call func(T &) for every live object, in memory order.
+     * func may destroy the object it is given, but must not make new objects.
+     * @param func
+     */
+    template<typename FUNC>
+    void forEach(FUNC &&func)
+    {
+        for (Slab *slab: mSlabs) {
+            if (slab->info.liveCount == 0) {
+                continue;
+            }
+            T *const objects = slab->objects();
+            for (size_t w = 0; w < BITMAP_WORDS; w++) {
+                uint64_t bits = slab->live[w];
+                while (bits) {
+                    func(objects[w * 64 + details::lowestBit64(bits)]);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+    template<typename FUNC>
+    void forEach(FUNC &&func) const
+    {
+        const_cast<ObjectPool *>(this)->forEach([&func](const T &object) {
+            func(object);
+        });
+    }
+
+    /**
+     * @brief Destroy all live objects, the slabs are kept.
+     */
+    void clear() noexcept
+    {
+        forEach([this](T &object) {
+            destroy(&object);
+        });
+    }
+
+    /**
+     * @brief Free the slabs without live objects.
+     */
+    void trim() noexcept
+    {
+        mPartial = nullptr;
+        auto it = std::remove_if(mSlabs.begin(), mSlabs.end(), [](Slab *slab) {
+            if (slab->info.liveCount == 0) {
+                alignedFree(slab);
+                return true;
+            }
+            return false;
+        });
+        mSlabs.erase(it, mSlabs.end());
+
+        // Rebuild the partial list so that lower addresses are filled first
+        for (auto r = mSlabs.rbegin(); r != mSlabs.rend(); ++r) {
+            Slab *slab = *r;
+            slab->info.partial = slab->info.liveCount < SLOT_COUNT;
+            if (slab->info.partial) {
+                slab->info.nextPartial = mPartial;
+                mPartial = slab;
+            }
+        }
+    }
+
+    /**
+     * @brief Whether p points to a live object of this pool.
+     */
+    bool contains(const T *p) const noexcept
+    {
+        if (p == nullptr) {
+            return false;
+        }
+        Slab *const slab = slabOf(p);
+        if (!std::binary_search(mSlabs.begin(), mSlabs.end(), slab)) {
+            return false;
+        }
+        const size_t offset = uintptr_t(p) - uintptr_t(slab->objects());
+        if (uintptr_t(p) < uintptr_t(slab->objects()) || offset % sizeof(T) != 0) {
+            return false;
+        }
+        const size_t index = offset / sizeof(T);
+        return index < SLOT_COUNT && (slab->live[index / 64] & (uint64_t(1) << (index % 64)));
+    }
+
+    /**
+     * @brief Number of live objects.
+     */
+    size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief Number of slots in all slabs.
+     */
+    size_t capacity() const noexcept
+    {
+        return mSlabs.size() * SLOT_COUNT;
+    }
+
+    friend void swap(ObjectPool &lhs, ObjectPool &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mSlabs, rhs.mSlabs);
+        swap(lhs.mPartial, rhs.mPartial);
+        swap(lhs.mSize, rhs.mSize);
+    }
+
+private:
+    static Slab *slabOf(const T *p) noexcept
+    {
+        return reinterpret_cast<Slab *>(uintptr_t(p) & ~(SLAB_BYTES - 1));
+    }
+
+    /// A partial slab has a free slot below SLOT_COUNT, the bits past it are never reached
+    static size_t lowestFreeSlot(const Slab *slab) noexcept
+    {
+        for (size_t w = 0; w < BITMAP_WORDS; w++) {
+            const uint64_t free = ~slab->live[w];
+            if (free) {
+                return w * 64 + details::lowestBit64(free);
+            }
+        }
+        GX_ASSERT_S(false, "ObjectPool: partial slab without free slot");
+        return 0;
+    }
+
+    Slab *createSlab()
+    {
+        void *const p = alignedAlloc(SLAB_BYTES, SLAB_BYTES);
+        if (p == nullptr) {
+            return nullptr;
+        }
+        Slab *const slab = new(p) Slab();
+        slab->info.partial = true;
+        slab->info.nextPartial = mPartial;
+        mPartial = slab;
+
+        // Sorted by address, forEach() then runs in memory order
+        mSlabs.insert(std::upper_bound(mSlabs.begin(), mSlabs.end(), slab), slab);
+        return slab;
+    }
+
+private:
+    std::vector<Slab *> mSlabs;
+    Slab *mPartial = nullptr;
+    size_t mSize = 0;
+};
+
+GX_NS_END
+
+#endif //GX_OBJECT_POOL_H
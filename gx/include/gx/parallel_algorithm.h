@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef GX_PARALLEL_ALGORITHM_H
+#define GX_PARALLEL_ALGORITHM_H
+
+#include "gx/task_system.h"
+#include "gx/allocator.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <utility>
+
+
+GX_NS_BEGIN
+
+namespace details
+{
+
+/// Minimum number of elements per chunk of the parallel algorithms
+constexpr size_t PARALLEL_ALGORITHM_GRAIN = 8 * 1024;
+
+/// parallelSort() insertion sorts runs of this size before the merge passes
+constexpr size_t PARALLEL_SORT_RUN = 32;
+
+/**
+ * @brief Whether POND is a Pond over a fixed size allocator (PoolAllocator, DynamicPoolAllocator),
+ * which cannot give the variable sized arrays the parallel algorithms need.
+ */
+template<typename POND, typename = void>
+struct IsFixedSizePond : std::false_type
+{
+};
+
+template<typename POND>
+struct IsFixedSizePond<POND, std::void_t<decltype(std::declval<POND &>().getAllocator())>>
+        : HasElementSize<std::decay_t<decltype(std::declval<POND &>().getAllocator())>>
+{
+};
+
+/**
+ * @brief Array of T allocated from a Pond, destroyed and freed at scope exit.
+ * data() is nullptr when the pond is out of memory.
+ */
+template<typename POND, typename T>
+class PondScratch
+{
+    static_assert(!IsFixedSizePond<POND>::value,
+                  "Scratch memory needs a variable size pond, e.g. HeapPond or a Pond<TlsfAllocator>");
+
+public:
+    PondScratch(POND &pond, size_t count)
+            : mPond(pond),
+              mCount(count)
+    {
+        mData = count ? static_cast<T *>(pond.alloc(count * sizeof(T), alignof(T))) : nullptr;
+    }
+
+    ~PondScratch()
+    {
+        if (mData == nullptr) {
+            return;
+        }
+        if (mConstructed) {
+            std::destroy_n(mData, mCount);
+        }
+        mPond.free(mData, mCount * sizeof(T));
+    }
+
+    PondScratch(const PondScratch &) = delete;
+
+    PondScratch &operator=(const PondScratch &) = delete;
+
+public:
+    T *data() const
+    {
+        return mData;
+    }
+
+    T &operator[](size_t index) const
+    {
+        return mData[index];
+    }
+
+    void fill(const T &value)
+    {
+        std::uninitialized_fill_n(mData, mCount, value);
+        mConstructed = true;
+    }
+
+    /**
+     * @brief All elements were constructed by the caller, destroy them at scope exit
+     */
+    void setConstructed()
+    {
+        mConstructed = true;
+    }
+
+private:
+    POND &mPond;
+    size_t mCount;
+    T *mData;
+    bool mConstructed = false;
+};
+
+/**
+ * @brief Number of elements of a taken by the first d elements of the stable merge of a and b,
+ * equal elements of a come first.
+ */
+template<typename It1, typename It2, typename Compare>
+size_t mergeCoRank(size_t d, It1 a, size_t na, It2 b, size_t nb, Compare &comp)
+{
+    size_t lo = d > nb ? d - nb : 0;
+    size_t hi = std::min(d, na);
+    while (lo < hi) {
+        const size_t i = lo + (hi - lo) / 2;
+        // a[i] is merged before b[d - i - 1], so more than i elements come from a
+        if (!comp(b[d - i - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+enum class MergeOutput
+{
+    Copy,
+    Move,
+    /// Move construct into raw memory
+    Construct,
+};
+
+template<MergeOutput OUTPUT, typename Out, typename It>
+void mergeWrite(Out out, It from)
+{
+    if constexpr (OUTPUT == MergeOutput::Construct) {
+        using T = typename std::iterator_traits<Out>::value_type;
+        ::new(static_cast<void *>(std::addressof(*out))) T(std::move(*from));
+    } else {
+        *out = std::move(*from);
+    }
+}
+
+/**
+ * @brief Write elements [o0, o1) of the stable merge of a and b to out + o0,
+ * i0 and i1 being the co-ranks of o0 and o1. The pieces of one merge are independent of each other.
+ */
+template<MergeOutput OUTPUT, typename It1, typename It2, typename Out, typename Compare>
+void mergePiece(It1 a, It2 b, Out out, size_t o0, size_t o1, size_t i0, size_t i1, Compare &comp)
+{
+    It1 first1 = a + i0;
+    const It1 last1 = a + i1;
+    It2 first2 = b + (o0 - i0);
+    const It2 last2 = b + (o1 - i1);
+    out += o0;
+
+    if constexpr (OUTPUT == MergeOutput::Copy) {
+        std::merge(first1, last1, first2, last2, out, comp);
+    } else {
+        while (first1 != last1 && first2 != last2) {
+            if (comp(*first2, *first1)) {
+                mergeWrite<OUTPUT>(out, first2);
+                ++first2;
+            } else {
+                mergeWrite<OUTPUT>(out, first1);
+                ++first1;
+            }
+            ++out;
+        }
+        for (; first1 != last1; ++first1, ++out) {
+            mergeWrite<OUTPUT>(out, first1);
+        }
+        for (; first2 != last2; ++first2, ++out) {
+            mergeWrite<OUTPUT>(out, first2);
+        }
+    }
+}
+
+template<typename It, typename Compare>
+void insertionSort(It first, It last, Compare &comp)
+{
+    if (first == last) {
+        return;
+    }
+    for (It i = first + 1; i != last; ++i) {
+        if (comp(*i, *(i - 1))) {
+            auto value = std::move(*i);
+            It j = i;
+            do {
+                *j = std::move(*(j - 1));
+                --j;
+            } while (j != first && comp(value, *(j - 1)));
+            *j = std::move(value);
+        }
+    }
+}
+
+/**
+ * @brief Merge the sorted runs of width elements of src pairwise into dst.
+ * Small runs are grouped into one chunk, large runs are split into pieces, so every pass uses all threads.
+ */
+template<MergeOutput OUTPUT, typename POND, typename Src, typename Dst, typename Compare>
+void mergePass(TaskSystem &system, POND &scratch, Src src, Dst dst, size_t n, size_t width, Compare &comp)
+{
+    const size_t pairs = (n + 2 * width - 1) / (2 * width);
+    const size_t grain = std::max<size_t>(1, PARALLEL_ALGORITHM_GRAIN / (2 * width));
+    size_t piecesPerPair = std::max<size_t>(1, 2 * width / PARALLEL_ALGORITHM_GRAIN);
+
+    // All co-ranks are found before any element is moved, a moved-from element (e.g. std::string) no longer compares.
+    // Without memory for them, each pair is merged as a whole
+    const size_t coRankCount = piecesPerPair > 1 ? pairs * (piecesPerPair + 1) : 0;
+    PondScratch<POND, size_t> coRanks(scratch, coRankCount);
+    if (!coRanks.data()) {
+        piecesPerPair = 1;
+    }
+
+    auto pieceBounds = [&](size_t pair, size_t piece) {
+        const size_t lo = pair * 2 * width;
+        return (std::min(n, lo + 2 * width) - lo) * piece / piecesPerPair;
+    };
+
+    if (piecesPerPair > 1) {
+        system.parallelFor(size_t(0), coRankCount, 1, [&](size_t k) {
+            const size_t pair = k / (piecesPerPair + 1);
+            const size_t lo = pair * 2 * width;
+            const size_t mid = std::min(n, lo + width);
+            const size_t hi = std::min(n, lo + 2 * width);
+            coRanks[k] = mergeCoRank(pieceBounds(pair, k % (piecesPerPair + 1)), src + lo, mid - lo,
+                                     src + mid, hi - mid, comp);
+        });
+    }
+
+    system.parallelFor(size_t(0), pairs * piecesPerPair, grain, [&](size_t t) {
+        const size_t pair = t / piecesPerPair;
+        const size_t piece = t % piecesPerPair;
+        const size_t lo = pair * 2 * width;
+        const size_t mid = std::min(n, lo + width);
+        const size_t hi = std::min(n, lo + 2 * width);
+        if (piecesPerPair > 1) {
+            const size_t k = pair * (piecesPerPair + 1) + piece;
+            mergePiece<OUTPUT>(src + lo, src + mid, dst + lo, pieceBounds(pair, piece), pieceBounds(pair, piece + 1),
+                               coRanks[k], coRanks[k + 1], comp);
+        } else {
+            mergePiece<OUTPUT>(src + lo, src + mid, dst + lo, 0, hi - lo, 0, mid - lo, comp);
+        }
+    });
+}
+
+template<bool INCLUSIVE, typename POND, typename InIt, typename OutIt, typename T, typename Op>
+OutIt parallelScan(TaskSystem &system, POND &scratch, InIt first, InIt last, OutIt out, const T *init, Op &op)
+{
+    const size_t n = size_t(last - first);
+    const size_t blocks = std::min<size_t>((n + PARALLEL_ALGORITHM_GRAIN - 1) / PARALLEL_ALGORITHM_GRAIN,
+                                           size_t(system.threadCount() + 1) * 4);
+    PondScratch<POND, T> carries(scratch, blocks);
+    if (blocks <= 1 || !carries.data()) {
+        if constexpr (INCLUSIVE) {
+            return std::inclusive_scan(first, last, out, op);
+        } else {
+            return std::exclusive_scan(first, last, out, *init, op);
+        }
+    }
+    carries.fill(*first);
+
+    // Reduce each block, then turn the block sums into the carry into each block
+    system.parallelFor(size_t(0), blocks, 1, [&](size_t b) {
+        const size_t b0 = n * b / blocks;
+        const size_t b1 = n * (b + 1) / blocks;
+        carries[b] = std::accumulate(first + b0 + 1, first + b1, T(first[b0]), op);
+    });
+    T carry = INCLUSIVE ? carries[0] : *init;
+    for (size_t b = INCLUSIVE ? 1 : 0; b < blocks; b++) {
+        T sum = std::move(carries[b]);
+        carries[b] = carry;
+        carry = op(std::move(carry), std::move(sum));
+    }
+
+    system.parallelFor(size_t(0), blocks, 1, [&](size_t b) {
+        const size_t b0 = n * b / blocks;
+        const size_t b1 = n * (b + 1) / blocks;
+        if constexpr (INCLUSIVE) {
+            if (b == 0) {
+                std::inclusive_scan(first + b0, first + b1, out + b0, op);
+            } else {
+                std::inclusive_scan(first + b0, first + b1, out + b0, op, carries[b]);
+            }
+        } else {
+            std::exclusive_scan(first + b0, first + b1, out + b0, carries[b], op);
+        }
+    });
+    return out + n;
+}
+
+}
+
+/**
+ * @brief Stable parallel merge sort of a random access range.
+ * Runs of 32 elements are insertion sorted, then merged pairwise in passes that alternate
+ * between the range and a scratch array of the same size allocated from scratch.
+ * Every pass is split into chunks of about 8K elements, a long merge is cut at co-ranks into independent pieces.
+ * Falls back to std::stable_sort when scratch cannot provide the array.
+ * @param scratch Pond of a variable size allocator (e.g. HeapPond, TlsfAllocator),
+ * or an object with alloc(size, alignment) and free(p, size). Pool ponds are rejected at compile time.
+ */
+template<typename POND, typename It, typename Compare = std::less<>>
+void parallelSort(TaskSystem &system, POND &scratch, It first, It last, Compare comp = {})
+{
+    using T = typename std::iterator_traits<It>::value_type;
+    constexpr size_t RUN = details::PARALLEL_SORT_RUN;
+
+    const size_t n = size_t(last - first);
+    if (n <= RUN) {
+        details::insertionSort(first, last, comp);
+        return;
+    }
+    details::PondScratch<POND, T> buffer(scratch, n);
+    if (!buffer.data()) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+
+    const size_t runs = (n + RUN - 1) / RUN;
+    system.parallelFor(size_t(0), runs, details::PARALLEL_ALGORITHM_GRAIN / RUN, [&](size_t r) {
+        details::insertionSort(first + r * RUN, first + std::min(n, (r + 1) * RUN), comp);
+    });
+
+    // The first pass move constructs the scratch elements, trivially copyable types need no construction
+    constexpr auto FIRST_OUTPUT = std::is_trivially_copyable_v<T> ? details::MergeOutput::Move
+                                                                  : details::MergeOutput::Construct;
+    details::mergePass<FIRST_OUTPUT>(system, scratch, first, buffer.data(), n, RUN, comp);
+    if constexpr (!std::is_trivially_copyable_v<T>) {
+        buffer.setConstructed();
+    }
+    bool inBuffer = true;
+    for (size_t width = RUN * 2; width < n; width *= 2) {
+        if (inBuffer) {
+            details::mergePass<details::MergeOutput::Move>(system, scratch, buffer.data(), first, n, width, comp);
+        } else {
+            details::mergePass<details::MergeOutput::Move>(system, scratch, first, buffer.data(), n, width, comp);
+        }
+        inBuffer = !inBuffer;
+    }
+    if (inBuffer) {
+        T *const data = buffer.data();
+        system.parallelFor(size_t(0), n, details::PARALLEL_ALGORITHM_GRAIN, [&](size_t b, size_t e) {
+            std::move(data + b, data + e, first + b);
+        });
+    }
+}
+
+/**
+ * @brief Stable parallel merge of two sorted ranges into out, like std::merge.
+ * The output is cut into chunks of about 8K elements, each finds its start in both inputs by binary search,
+ * so no scratch memory is needed.
+ * @return End of the output
+ */
+template<typename It1, typename It2, typename Out, typename Compare = std::less<>>
+Out parallelMerge(TaskSystem &system, It1 first1, It1 last1, It2 first2, It2 last2, Out out, Compare comp = {})
+{
+    const size_t na = size_t(last1 - first1);
+    const size_t nb = size_t(last2 - first2);
+    const size_t n = na + nb;
+    const size_t pieces = (n + details::PARALLEL_ALGORITHM_GRAIN - 1) / details::PARALLEL_ALGORITHM_GRAIN;
+    system.parallelFor(size_t(0), pieces, 1, [&](size_t p) {
+        const size_t o0 = n * p / pieces;
+        const size_t o1 = n * (p + 1) / pieces;
+        details::mergePiece<details::MergeOutput::Copy>(first1, first2, out, o0, o1,
+                                                        details::mergeCoRank(o0, first1, na, first2, nb, comp),
+                                                        details::mergeCoRank(o1, first1, na, first2, nb, comp),
+                                                        comp);
+    });
+    return out + n;
+}
+
+/**
+ * @brief Parallel inclusive prefix scan, like std::inclusive_scan, out may be first.
+ * Two passes over blocks: the block sums are reduced in parallel, scanned serially into the carry of
+ * each block (kept in an array allocated from scratch, a variable size pond as for parallelSort()),
+ * then each block is scanned from its carry.
+ * op must be associative.
+ * @return End of the output
+ */
+template<typename POND, typename InIt, typename OutIt, typename Op = std::plus<>>
+OutIt parallelInclusiveScan(TaskSystem &system, POND &scratch, InIt first, InIt last, OutIt out, Op op = {})
+{
+    using T = typename std::iterator_traits<InIt>::value_type;
+    if (first == last) {
+        return out;
+    }
+    return details::parallelScan<true>(system, scratch, first, last, out, static_cast<const T *>(nullptr), op);
+}
+
+/**
+ * @brief Parallel exclusive prefix scan, like std::exclusive_scan, out may be first.
+ * Same block scheme as parallelInclusiveScan(), e.g. turns sizes into an offset table.
+ * @return End of the output
+ */
+template<typename POND, typename InIt, typename OutIt, typename T, typename Op = std::plus<>>
+OutIt parallelExclusiveScan(TaskSystem &system, POND &scratch, InIt first, InIt last, OutIt out, T init, Op op = {})
+{
+    if (first == last) {
+        return out;
+    }
+    return details::parallelScan<false>(system, scratch, first, last, out, &init, op);
+}
+
+GX_NS_END
+
+#endif //GX_PARALLEL_ALGORITHM_H
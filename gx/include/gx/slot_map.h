@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GX_SLOT_MAP_H
+#define GX_SLOT_MAP_H
+
+#include "gx/gid_allocator.h"
+
+#include "debug.h"
+
+#include <vector>
+#include <utility>
+
+
+GX_NS_BEGIN
+
+/**
+ * @class SlotMap
+ * @brief Values addressed by generational handles (GHandle), stored in a dense contiguous array.
+ * Same dense / sparse scheme as GIDAllocator: the sparse slots map a handle to its dense position,
+ * erase() moves the last value into the hole, so iteration is a linear scan over data().
+ * insert(), erase() and get() are O(1), a handle of an erased value fails validation
+ * even after its slot was reused.
+ * Pointers and dense positions change on insert() / erase(), keep handles instead.
+ * Not thread safe.
+ * @tparam T
+ */
+template<typename T>
+class SlotMap
+{
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+public:
+    SlotMap() = default;
+
+    SlotMap(const SlotMap &) = default;
+
+    SlotMap(SlotMap &&) noexcept = default;
+
+    SlotMap &operator=(const SlotMap &) = default;
+
+    SlotMap &operator=(SlotMap &&) noexcept = default;
+
+public:
+    template<typename... ARGS>
+    GHandle insert(ARGS &&... args)
+    {
+        uint32_t index = mFreeHead;
+        if (index != GHandle::NULL_INDEX) {
+            mFreeHead = mSlots[index].dense;
+        } else {
+            GX_ASSERT(mSlots.size() < GHandle::NULL_INDEX);
+            index = (uint32_t) mSlots.size();
+            mSlots.push_back(Slot{});
+        }
+        mValues.emplace_back(std::forward<ARGS>(args)...);
+        mDenseToSlot.push_back(index);
+
+        Slot &slot = mSlots[index];
+        slot.dense = (uint32_t) mValues.size() - 1;
+        // Odd while alive
+        ++slot.generation;
+        return GHandle{index, slot.generation};
+    }
+
+    /**
+     * @return false if the handle is stale or null
+     */
+    bool erase(GHandle handle)
+    {
+        if (!contains(handle)) {
+            return false;
+        }
+        Slot &slot = mSlots[handle.index];
+        const uint32_t dense = slot.dense;
+        const uint32_t last = (uint32_t) mValues.size() - 1;
+        if (dense != last) {
+            mValues[dense] = std::move(mValues[last]);
+            mDenseToSlot[dense] = mDenseToSlot[last];
+            mSlots[mDenseToSlot[dense]].dense = dense;
+        }
+        mValues.pop_back();
+        mDenseToSlot.pop_back();
+
+        ++slot.generation;
+        slot.dense = mFreeHead;
+        mFreeHead = handle.index;
+        return true;
+    }
+
+    bool contains(GHandle handle) const noexcept
+    {
+        return handle.index < mSlots.size()
+               && (handle.generation & 1)
+               && mSlots[handle.index].generation == handle.generation;
+    }
+
+    /**
+     * @return nullptr if the handle is stale or null
+     */
+    T *get(GHandle handle) noexcept
+    {
+        return contains(handle) ? &mValues[mSlots[handle.index].dense] : nullptr;
+    }
+
+    const T *get(GHandle handle) const noexcept
+    {
+        return contains(handle) ? &mValues[mSlots[handle.index].dense] : nullptr;
+    }
+
+    /**
+     * @brief Handle of the value at a dense position, e.g. while iterating.
+     */
+    GHandle handleAt(size_t denseIndex) const noexcept
+    {
+        GX_ASSERT(denseIndex < mValues.size());
+        const uint32_t index = mDenseToSlot[denseIndex];
+        return GHandle{index, mSlots[index].generation};
+    }
+
+    /**
+     * @brief Call func(GHandle, T &) for every value, in dense order.
+     * func must not insert or erase.
+     */
+    template<typename FUNC>
+    void forEach(FUNC &&func)
+    {
+        for (size_t i = 0; i < mValues.size(); i++) {
+            func(handleAt(i), mValues[i]);
+        }
+    }
+
+    /**
+     * @brief Erase every value, all handles become stale.
+     */
+    void clear()
+    {
+        for (uint32_t index: mDenseToSlot) {
+            Slot &slot = mSlots[index];
+            ++slot.generation;
+            slot.dense = mFreeHead;
+            mFreeHead = index;
+        }
+        mValues.clear();
+        mDenseToSlot.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        mValues.reserve(count);
+        mDenseToSlot.reserve(count);
+        mSlots.reserve(count);
+    }
+
+    size_t size() const noexcept
+    { return mValues.size(); }
+
+    bool empty() const noexcept
+    { return mValues.empty(); }
+
+    T *data() noexcept
+    { return mValues.data(); }
+
+    const T *data() const noexcept
+    { return mValues.data(); }
+
+    iterator begin() noexcept
+    { return mValues.begin(); }
+
+    iterator end() noexcept
+    { return mValues.end(); }
+
+    const_iterator begin() const noexcept
+    { return mValues.begin(); }
+
+    const_iterator end() const noexcept
+    { return mValues.end(); }
+
+private:
+    struct Slot
+    {
+        /// Dense position while alive, next free slot otherwise
+        uint32_t dense = GHandle::NULL_INDEX;
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> mValues;
+    std::vector<uint32_t> mDenseToSlot;
+    std::vector<Slot> mSlots;
+    uint32_t mFreeHead = GHandle::NULL_INDEX;
+};
+
+GX_NS_END
+
+#endif //GX_SLOT_MAP_H
@@ -29,30 +29,173 @@
 #include "gthread.h"
 #include "gx/gmutex.h"
 #include "gtimer.h"
+#include "debug.h"
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <functional>
 #include <list>
 #include <memory>
+#include <optional>
+#include <type_traits>
 #include <vector>
 
 
 GX_NS_BEGIN
 
+class TaskGraph;
+
+namespace details
+{
+
+/**
+ * @brief Completion state shared by a Task, the queued task function and the continuations.
+ * Completed exactly once, by the worker running the task or by abandon() when it will never run.
+ * Continuations added before completion run on the completing thread, later ones run at once.
+ */
+class GX_API TaskStateBase
+{
+public:
+    virtual ~TaskStateBase() = default;
+
+public:
+    bool isReady() const
+    {
+        return mReady.load(std::memory_order_acquire);
+    }
+
+    bool isActive() const
+    {
+        return mActive.load(std::memory_order_relaxed);
+    }
+
+    void deactivate()
+    {
+        mActive.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Only meaningful once ready
+     */
+    bool hasError() const
+    {
+        return mError != nullptr;
+    }
+
+    std::exception_ptr error() const
+    {
+        return mError;
+    }
+
+    void wait();
+
+    bool waitFor(int64_t ms);
+
+    void onComplete(std::function<void()> func);
+
+    void setError(std::exception_ptr error);
+
+    /**
+     * @brief Called instead of the task function when the task is cancelled or dropped from the queue.
+     * Completes with std::future_error(broken_promise), like a std::promise destroyed unsatisfied.
+     */
+    virtual void abandon();
+
+protected:
+    void complete();
+
+protected:
+    std::exception_ptr mError;
+
+private:
+    std::atomic<bool> mReady{false};
+    std::atomic<bool> mActive{true};
+
+    GMutex mLock;
+    std::condition_variable mCond;
+    std::vector<std::function<void()>> mContinuations;
+};
+
+template<typename T>
+class TaskState : public TaskStateBase
+{
+public:
+    template<typename F>
+    void run(F &&func)
+    {
+        try {
+            mValue.emplace(func());
+        } catch (...) {
+            mError = std::current_exception();
+        }
+        complete();
+    }
+
+    void setValue(T value)
+    {
+        mValue.emplace(std::move(value));
+        complete();
+    }
+
+    /**
+     * @brief Wait and move the result out, rethrows the exception of a failed task. Only once.
+     */
+    T take()
+    {
+        wait();
+        if (mRetrieved.exchange(true)) {
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        }
+        if (mError) {
+            std::rethrow_exception(mError);
+        }
+        return std::move(*mValue);
+    }
+
+    bool isRetrieved() const
+    {
+        return mRetrieved.load(std::memory_order_relaxed);
+    }
+
+protected:
+    std::optional<T> mValue;
+    std::atomic<bool> mRetrieved{false};
+};
+
+}
+
 /**
  * @class TaskSystem
  * @brief Multi threaded task system (thread pool)
+ * In SharedQueue mode all workers take tasks from one FIFO queue.
+ * In WorkStealing mode each worker owns a Chase-Lev deque: tasks submitted from a worker go to its own deque
+ * (run in LIFO order by the owner), tasks submitted from other threads go to a global injection queue,
+ * and idle workers steal from the other workers' deques, oldest first.
+ * This scales much better for many small tasks, at the cost of a strict FIFO order.
  */
 class GX_API TaskSystem final
 {
 public:
+    enum Mode
+    {
+        SharedQueue,
+        WorkStealing,
+    };
+
+
+public:
+    /// Result type of a task whose function returns R, void becomes bool
+    template<typename R>
+    using TaskResult = std::conditional_t<std::is_void_v<R>, bool, R>;
+
     template<class T>
     class Task
     {
     private:
-        Task(std::future<T> &&future, const std::shared_ptr<std::atomic<bool>>& active)
-                : mFuture(std::make_shared<std::future<T>>(std::move(future))), mActive(active)
+        Task(std::shared_ptr<details::TaskState<T>> state, TaskSystem *system)
+                : mState(std::move(state)), mSystem(system)
         {}
 
     public:
@@ -61,112 +204,147 @@ public:
 
         Task(const Task &other) = delete;
 
-        Task(Task &&other) noexcept
-        {
-            mFuture = other.mFuture;
-            mActive = other.mActive;
-            other.mFuture = nullptr;
-        }
+        Task(Task &&other) noexcept = default;
 
         Task &operator=(const Task &other) = delete;
 
-        Task &operator=(Task &&other) noexcept
-        {
-            if (this != &other) {
-                mFuture = other.mFuture;
-                mActive = other.mActive;
-
-                other.mFuture = nullptr;
-                other.mActive = nullptr;
-            }
-            return *this;
-        }
+        Task &operator=(Task &&other) noexcept = default;
 
     public:
+        /**
+         * @brief Wait for the result, rethrows the exception thrown by the task function.
+         * A cancelled task throws std::future_error(broken_promise).
+         */
         T get()
         {
-            return mFuture->get();
+            if (!mState) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            return mState->take();
         }
 
         void wait()
         {
-            mFuture->wait();
+            if (mState) {
+                mState->wait();
+            }
         }
 
         bool waitFor(int64_t ms)
         {
-            auto status = mFuture->wait_for(std::chrono::milliseconds(ms));
-            return status != std::future_status::timeout;
+            return !mState || mState->waitFor(ms);
         }
 
         void cancel()
         {
-            auto active = mActive.lock();
-            if (active) {
-                active->store(false);
-                auto timer = mObserverTimer;
-                if (timer) {
-                    timer->stop();
-                    timer->timerEvent(nullptr);
-                }
+            if (mState) {
+                mState->deactivate();
             }
         }
 
+        /**
+         * @brief Submit func(result) to the TaskSystem once this task has completed, nothing is blocked meanwhile.
+         * The result is moved into func, this Task is no longer valid afterwards.
+         * If this task failed or was cancelled, func is skipped and the returned task fails with the same error.
+         * @return Task of the result of func
+         */
+        template<typename F, typename R = std::invoke_result_t<std::decay_t<F>, T>>
+        Task<TaskResult<R>> then(F &&func)
+        {
+            GX_ASSERT_S(mState && mSystem, "Task::then: invalid task");
+            auto next = std::make_shared<details::TaskState<TaskResult<R>>>();
+            auto state = std::move(mState);
+            TaskSystem *system = mSystem;
+
+            // The continuation lives in the state's own list, a strong reference would keep it alive forever
+            std::weak_ptr<details::TaskState<T>> weakState = state;
+            state->onComplete([weakState, next, system, func = std::forward<F>(func)]() {
+                auto state = weakState.lock();
+                if (!state) {
+                    next->abandon();
+                    return;
+                }
+                if (state->hasError()) {
+                    next->setError(state->error());
+                    return;
+                }
+                if (!next->isActive()) {
+                    next->abandon();
+                    return;
+                }
+                system->pushTask([state, next, func]() {
+                    next->run([&]() -> TaskResult<R> {
+                        if constexpr (std::is_void_v<R>) {
+                            func(state->take());
+                            return true;
+                        } else {
+                            return func(state->take());
+                        }
+                    });
+                }, next);
+            });
+            return {std::move(next), system};
+        }
+
+        /**
+         * @brief Call action(result) once the task has completed, pushed by the completing thread:
+         * posted to scheduler, or run inline on the completing thread when scheduler is null.
+         * Not called if the task fails, is cancelled, its result was already taken,
+         * or the scheduler is destroyed before the task completes.
+         */
         template<typename Action>
         void subscribe(Action action, const GTimerSchedulerPtr &scheduler = nullptr)
         {
-            auto timer = mObserverTimer = std::make_shared<GTimer>(scheduler);
-            auto future = mFuture;
-            auto active = mActive;
-            mObserverTimer->timerEvent([future, active, timer, action]() {
-                while (true) {
-                    if (!future->valid()) {
-                        break;
-                    }
-                    auto activeFlag = active.lock();
-                    if (!activeFlag || !activeFlag->load()) {
-                        break;
-                    }
-                    auto status = future->wait_for(std::chrono::milliseconds(0));
-                    if (status != std::future_status::timeout) {
-                        action(future->get());
-                        break;
-                    }
+            if (!mState) {
+                return;
+            }
+            auto state = mState;
+            std::weak_ptr<GTimerScheduler> weakScheduler = scheduler;
+            const bool runInline = scheduler == nullptr;
+
+            std::weak_ptr<details::TaskState<T>> weakState = state;
+            state->onComplete([weakState, action, weakScheduler, runInline]() {
+                auto state = weakState.lock();
+                if (!state || state->hasError() || !state->isActive()) {
                     return;
                 }
-                timer->stop();
-                timer->timerEvent(nullptr);
+                auto deliver = [state, action]() {
+                    if (state->isActive() && !state->isRetrieved()) {
+                        action(state->take());
+                    }
+                };
+                if (runInline) {
+                    deliver();
+                } else if (auto target = weakScheduler.lock()) {
+                    target->post(std::move(deliver), 0);
+                }
             });
-            mObserverTimer->start(0, 10);
         }
 
         bool isValid() const
         {
-            if (!mFuture->valid()) {
-                return false;
-            }
-            auto active = mActive.lock();
-            if (active) {
-                return active->load();
-            }
-            return false;
+            return mState && !mState->isRetrieved() && mState->isActive();
         }
 
     private:
         friend class TaskSystem;
 
-        std::shared_ptr<std::future<T>> mFuture;
-        std::weak_ptr<std::atomic<bool>> mActive;
+        friend class TaskGraph;
+
+        template<class>
+        friend class Task;
 
-        std::shared_ptr<GTimer> mObserverTimer;
+        std::shared_ptr<details::TaskState<T>> mState;
+        TaskSystem *mSystem = nullptr;
     };
 
+
 public:
     /**
      * @brief Construct Task System
      * @param threadCount    Number of threads, when using the default value of 0, the number of allocated threads is the number of CPU cores
      */
-    explicit TaskSystem(uint32_t threadCount = 0, std::string name = "TaskSystem");
+    explicit TaskSystem(uint32_t threadCount = 0, std::string name = "TaskSystem", Mode mode = SharedQueue);
 
     ~TaskSystem();
 
@@ -181,6 +359,8 @@ public:
 public:
     uint32_t threadCount() const;
 
+    Mode mode() const;
+
     /**
      * @brief Start Task System
      */
@@ -203,84 +383,315 @@ public:
     ThreadPriority getThreadPriority() const;
 
     template<typename F, typename... A,
-            typename = std::enable_if_t<std::is_void_v<std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>>>
-    Task<bool> submit(const F &taskFunc, const A &&... args)
+            typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    Task<TaskResult<R>> submit(const F &taskFunc, const A &&... args)
     {
-        auto promise = std::make_shared<std::promise<bool>>();
-        auto future = promise->get_future();
-        auto taskRef = pushTask(
-                [taskFunc, args..., promise] {
+        auto state = std::make_shared<details::TaskState<TaskResult<R>>>();
+        pushTask([taskFunc, args..., state] {
+            state->run([&]() -> TaskResult<R> {
+                if constexpr (std::is_void_v<R>) {
                     taskFunc(args...);
-                    promise->set_value(true);
-                });
-        return {std::move(future), taskRef.active};
+                    return true;
+                } else {
+                    return taskFunc(args...);
+                }
+            });
+        }, state);
+        return {std::move(state), this};
     }
 
     template<typename F, typename... A,
-            typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>,
-            typename = std::enable_if_t<!std::is_void_v<R>>>
-    Task<R> submit(const F &taskFunc, const A &&... args)
+            typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    Task<TaskResult<R>> submitFront(const F &taskFunc, const A &&... args)
     {
-        auto promise = std::make_shared<std::promise<R>>();
-        auto future = promise->get_future();
-        auto taskRef = pushTask([taskFunc, args..., promise] { promise->set_value(taskFunc(args...)); });
-        return {std::move(future), taskRef.active};
+        auto state = std::make_shared<details::TaskState<TaskResult<R>>>();
+        pushTaskFront([taskFunc, args..., state] {
+            state->run([&]() -> TaskResult<R> {
+                if constexpr (std::is_void_v<R>) {
+                    taskFunc(args...);
+                    return true;
+                } else {
+                    return taskFunc(args...);
+                }
+            });
+        }, state);
+        return {std::move(state), this};
     }
 
-    template<typename F, typename... A,
-            typename = std::enable_if_t<std::is_void_v<std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>>>
-    Task<bool> submitFront(const F &taskFunc, const A &&... args)
+    /**
+     * @brief Task that completes once all tasks have completed, without blocking a thread.
+     * It fails with the error of the first failed task in the list, if any.
+     * The tasks stay valid, their results are read with get() afterwards.
+     */
+    template<typename T>
+    static Task<bool> whenAll(std::vector<Task<T>> &tasks)
     {
-        auto promise = std::make_shared<std::promise<bool>>();
-        auto future = promise->get_future();
-        auto taskRef = pushTaskFront(
-                [taskFunc, args..., promise] {
-                    taskFunc(args...);
-                    promise->set_value(true);
-                });
-        return {std::move(future), taskRef.active};
+        using States = std::vector<std::shared_ptr<details::TaskState<T>>>;
+        auto all = std::make_shared<details::TaskState<bool>>();
+        auto states = std::make_shared<States>();
+        TaskSystem *system = nullptr;
+        for (auto &task: tasks) {
+            GX_ASSERT_S(task.mState, "TaskSystem::whenAll: invalid task");
+            states->push_back(task.mState);
+            system = system ? system : task.mSystem;
+        }
+
+        // One extra count, so that completion waits until every continuation is registered
+        auto pending = std::make_shared<std::atomic<size_t>>(states->size() + 1);
+        auto finish = [all, states, pending]() {
+            if (pending->fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            for (auto &state: *states) {
+                if (state->hasError()) {
+                    all->setError(state->error());
+                    return;
+                }
+            }
+            all->setValue(true);
+        };
+        for (auto &state: *states) {
+            state->onComplete(finish);
+        }
+        finish();
+        return {std::move(all), system};
     }
 
-    template<typename F, typename... A,
-            typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>,
-            typename = std::enable_if_t<!std::is_void_v<R>>>
-    Task<R> submitFront(const F &taskFunc, const A &&... args)
+    /**
+     * @brief Task whose result is the index of the first task to complete (successfully or not).
+     * The tasks stay valid, their results are read with get() afterwards.
+     */
+    template<typename T>
+    static Task<size_t> whenAny(std::vector<Task<T>> &tasks)
     {
-        auto promise = std::make_shared<std::promise<R>>();
-        auto future = promise->get_future();
-        auto taskRef = pushTaskFront([taskFunc, args..., promise] { promise->set_value(taskFunc(args...)); });
-        return {std::move(future), taskRef.active};
+        auto any = std::make_shared<details::TaskState<size_t>>();
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        TaskSystem *system = nullptr;
+        for (size_t i = 0; i < tasks.size(); i++) {
+            GX_ASSERT_S(tasks[i].mState, "TaskSystem::whenAny: invalid task");
+            system = system ? system : tasks[i].mSystem;
+            tasks[i].mState->onComplete([any, done, i]() {
+                if (!done->exchange(true, std::memory_order_acq_rel)) {
+                    any->setValue(i);
+                }
+            });
+        }
+        if (tasks.empty()) {
+            any->abandon();
+        }
+        return {std::move(any), system};
+    }
+
+    /**
+     * @brief Run body over [begin, end), split into chunks of at least grain indices,
+     * on the workers and on the calling thread, which also takes part and returns once all indices are done.
+     * body is either body(Index i) or body(Index chunkBegin, Index chunkEnd).
+     * Each participant starts with an equal share of the range, an idle participant steals half of the largest
+     * remaining share, so chunks are split further only where the load is uneven.
+     * Scheduling costs one allocation plus one queued task per helper worker, nothing per chunk.
+     * If body throws, the remaining chunks are skipped and the first exception is rethrown.
+     * @param grain Minimum chunk size, 0 picks one from the range size and the thread count
+     */
+    template<typename B, typename E, typename Body, typename Index = std::common_type_t<B, E>>
+    void parallelFor(B begin, E end, size_t grain, const Body &body)
+    {
+        static_assert(std::is_integral_v<Index>, "TaskSystem::parallelFor: integral indices only");
+        if (!(Index(begin) < Index(end))) {
+            return;
+        }
+        struct Context
+        {
+            const Body &body;
+            Index begin;
+        } context{body, Index(begin)};
+
+        const size_t count = size_t(Index(end) - Index(begin));
+        grain = resolveGrain(count, grain);
+        parallelRange(count, grain, participantCount(count, grain), [](void *ctx, uint32_t, size_t b, size_t e) {
+            auto &c = *static_cast<Context *>(ctx);
+            if constexpr (std::is_invocable_v<const Body &, Index, Index>) {
+                c.body(Index(c.begin + Index(b)), Index(c.begin + Index(e)));
+            } else {
+                for (size_t i = b; i < e; i++) {
+                    c.body(Index(c.begin + Index(i)));
+                }
+            }
+        }, &context);
+    }
+
+    /**
+     * @brief Reduce [begin, end) in parallel, partitioned like parallelFor().
+     * body is either body(Index i) -> T, whose results are combined with reduce,
+     * or body(Index chunkBegin, Index chunkEnd, T init) -> T, which folds a chunk into init.
+     * Each participant folds its chunks into its own partial result, the partial results are reduced in order.
+     * reduce must be associative and identity neutral, the grouping depends on the scheduling.
+     */
+    template<typename B, typename E, typename T, typename Body, typename Reduce,
+            typename Index = std::common_type_t<B, E>>
+    T parallelReduce(B begin, E end, size_t grain, T identity, const Body &body, const Reduce &reduce)
+    {
+        static_assert(std::is_integral_v<Index>, "TaskSystem::parallelReduce: integral indices only");
+        if (!(Index(begin) < Index(end))) {
+            return identity;
+        }
+        struct alignas(64) Partial
+        {
+            T value;
+        };
+        struct Context
+        {
+            const Body &body;
+            const Reduce &reduce;
+            Index begin;
+            std::vector<Partial> partials;
+        } context{body, reduce, Index(begin), {}};
+
+        const size_t count = size_t(Index(end) - Index(begin));
+        grain = resolveGrain(count, grain);
+        const uint32_t participants = participantCount(count, grain);
+        context.partials.assign(participants, Partial{identity});
+
+        parallelRange(count, grain, participants, [](void *ctx, uint32_t participant, size_t b, size_t e) {
+            auto &c = *static_cast<Context *>(ctx);
+            T &value = c.partials[participant].value;
+            if constexpr (std::is_invocable_v<const Body &, Index, Index, T>) {
+                value = c.body(Index(c.begin + Index(b)), Index(c.begin + Index(e)), std::move(value));
+            } else {
+                for (size_t i = b; i < e; i++) {
+                    value = c.reduce(std::move(value), c.body(Index(c.begin + Index(i))));
+                }
+            }
+        }, &context);
+
+        T result = std::move(identity);
+        for (auto &partial: context.partials) {
+            result = reduce(std::move(result), std::move(partial.value));
+        }
+        return result;
     }
 
     uint64_t waitingTaskCount() const;
 
 private:
+    friend class TaskGraph;
+
     using TaskFunc = std::function<void()>;
+    using TaskStatePtr = std::shared_ptr<details::TaskStateBase>;
+
     struct TaskFuncRef
     {
         TaskFunc func;
-        std::shared_ptr<std::atomic<bool>> active;
+        /// Optional, a task without state cannot be cancelled
+        TaskStatePtr state;
     };
 
-    TaskFuncRef pushTask(const TaskFunc &task);
+    struct Worker;
+
+    void pushTask(TaskFunc task, TaskStatePtr state);
 
-    TaskFuncRef pushTaskFront(const TaskFunc &task);
+    void pushTaskFront(TaskFunc task, TaskStatePtr state);
+
+    static void runTask(TaskFuncRef &taskRef);
 
     void clearTask();
 
+    /// func(context, participant, chunkBegin, chunkEnd)
+    using RangeFunc = void (*)(void *, uint32_t, size_t, size_t);
+
+    size_t resolveGrain(size_t count, size_t grain) const;
+
+    uint32_t participantCount(size_t count, size_t grain) const;
+
+    /// Run func over [0, count) on the calling thread (participant 0) and participants - 1 helper tasks
+    void parallelRange(size_t count, size_t grain, uint32_t participants, RangeFunc func, void *context);
+
+    void sharedQueueLoop();
+
+    void workStealingLoop(Worker *worker);
+
+    /// WorkStealing mode: own deque, then the injection queue, then the other workers
+    TaskFuncRef *findTask(Worker *worker);
+
+    TaskFuncRef *stealTask(Worker *worker);
+
+    bool hasQueuedTask() const;
+
+    void wakeWorker();
+
 private:
     uint32_t mThreadCount;
     std::string mName;
+    Mode mMode;
     ThreadPriority mPriority = ThreadPriority::Normal;
 
     std::vector<std::unique_ptr<GThread>> mThreads;
     std::list<TaskFuncRef> mTaskQueue;
 
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::deque<TaskFuncRef *> mInjectQueue;
+    std::atomic<size_t> mInjectCount{0};
+    std::atomic<uint32_t> mSleepingCount{0};
+    uint64_t mWakeEpoch = 0;
+
     mutable GMutex mLock;
     std::condition_variable mTaskCond;
     std::atomic<bool> mIsRunning{false};
 };
 
+/**
+ * @class TaskGraph
+ * @brief Tasks with explicit dependencies, each node is submitted as soon as all its predecessors have completed,
+ * so multi-stage work keeps the workers busy instead of blocking on intermediate results.
+ * Nodes and edges are added up front, then the graph can be run any number of times, also concurrently.
+ * The graph must outlive its runs.
+ * When a node throws or the run is cancelled, the nodes not started yet are skipped
+ * and the run fails with that error.
+ */
+class GX_API TaskGraph final
+{
+public:
+    using NodeId = uint32_t;
+
+public:
+    TaskGraph() = default;
+
+    TaskGraph(const TaskGraph &) = delete;
+
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+public:
+    NodeId add(std::function<void()> func);
+
+    /**
+     * @brief Node after starts once node before has completed
+     */
+    void precede(NodeId before, NodeId after);
+
+    size_t size() const;
+
+    /**
+     * @brief Submit the nodes without predecessors, the others follow as they become ready.
+     * A graph with a cycle is not run, the returned task fails with std::logic_error.
+     * @return Task completed once every node has run
+     */
+    TaskSystem::Task<bool> run(TaskSystem &system);
+
+private:
+    struct Node
+    {
+        std::function<void()> func;
+        std::vector<NodeId> successors;
+        uint32_t predecessorCount = 0;
+    };
+
+    class Run;
+
+    bool hasCycle() const;
+
+private:
+    std::vector<Node> mNodes;
+};
+
 GX_NS_END
 
 #endif //GX_TASK_SYSTEM_H
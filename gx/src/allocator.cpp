@@ -0,0 +1,906 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "gx/allocator.h"
+
+#include "gx/debug.h"
+
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+#if GX_PLATFORM_WINDOWS
+
+#include <windows.h>
+
+#else
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if GX_PLATFORM_LINUX
+
+#include <sched.h>
+#include <sys/syscall.h>
+
+#endif
+
+#if GX_ADAPTIVE_LOCK_FUTEX
+
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#endif
+
+#endif
+
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+GX_NS_BEGIN
+
+#if GX_PLATFORM_WINDOWS
+
+size_t systemPageSize() noexcept
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t) info.dwPageSize;
+}
+
+HugePageArea::HugePageArea(size_t size, uint32_t flags)
+{
+    if (size == 0) {
+        return;
+    }
+    // Large pages need SeLockMemoryPrivilege, only the regular path is used here
+    const size_t mapSize = pointer::alignSize(size, systemPageSize());
+    void *p = VirtualAlloc(nullptr, mapSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!p) {
+        LogE("HugePageArea: VirtualAlloc(%zu) failed", mapSize);
+        return;
+    }
+    mBegin = p;
+    mEnd = pointer::add(p, size);
+    mMapSize = mapSize;
+
+    if (flags & Populate) {
+        const size_t pageSize = systemPageSize();
+        for (size_t offset = 0; offset < mapSize; offset += pageSize) {
+            *((volatile char *) p + offset) = 0;
+        }
+    }
+}
+
+HugePageArea::~HugePageArea() noexcept
+{
+    if (mBegin) {
+        VirtualFree(mBegin, 0, MEM_RELEASE);
+    }
+}
+
+size_t decommitMemory(void *begin, void *end) noexcept
+{
+    const size_t pageSize = systemPageSize();
+    void *const first = pointer::align(begin, pageSize);
+    void *const last = (void *) (uintptr_t(end) & ~(pageSize - 1));
+    if (first >= last) {
+        return 0;
+    }
+    const size_t size = uintptr_t(last) - uintptr_t(first);
+    VirtualAlloc(first, size, MEM_RESET, PAGE_READWRITE);
+    return size;
+}
+
+#else
+
+size_t systemPageSize() noexcept
+{
+    return (size_t) sysconf(_SC_PAGESIZE);
+}
+
+HugePageArea::HugePageArea(size_t size, uint32_t flags)
+{
+    if (size == 0) {
+        return;
+    }
+    int mapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    mapFlags |= MAP_NORESERVE;
+#endif
+
+#ifdef MAP_HUGETLB
+    if (flags & HugePages) {
+        const size_t mapSize = pointer::alignSize(size, HUGE_PAGE_SIZE);
+        int hugeFlags = mapFlags | MAP_HUGETLB;
+#ifdef MAP_POPULATE
+        if (flags & Populate) {
+            hugeFlags |= MAP_POPULATE;
+        }
+#endif
+        void *p = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, hugeFlags, -1, 0);
+        if (p != MAP_FAILED) {
+            mBegin = p;
+            mEnd = pointer::add(p, size);
+            mMapSize = mapSize;
+            mHugeTlb = true;
+            return;
+        }
+    }
+#endif
+
+    const size_t pageSize = systemPageSize();
+    const bool transparent = flags & (HugePages | TransparentHugePages);
+    const size_t alignment = transparent ? HUGE_PAGE_SIZE : pageSize;
+    const size_t mapSize = pointer::alignSize(size, transparent ? HUGE_PAGE_SIZE : pageSize);
+
+    // Over reserve to align the range, then give the slack back
+    const size_t reserveSize = mapSize + (alignment > pageSize ? alignment : 0);
+    void *p = mmap(nullptr, reserveSize, PROT_READ | PROT_WRITE, mapFlags, -1, 0);
+    if (p == MAP_FAILED) {
+        LogE("HugePageArea: mmap(%zu) failed", reserveSize);
+        return;
+    }
+    void *begin = pointer::align(p, alignment);
+    const size_t head = uintptr_t(begin) - uintptr_t(p);
+    const size_t tail = reserveSize - head - mapSize;
+    if (head) {
+        munmap(p, head);
+    }
+    if (tail) {
+        munmap(pointer::add(begin, mapSize), tail);
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (transparent) {
+        madvise(begin, mapSize, MADV_HUGEPAGE);
+    }
+#endif
+
+    mBegin = begin;
+    mEnd = pointer::add(begin, size);
+    mMapSize = mapSize;
+
+    if (flags & Populate) {
+        for (size_t offset = 0; offset < mapSize; offset += pageSize) {
+            *((volatile char *) begin + offset) = 0;
+        }
+    }
+}
+
+HugePageArea::~HugePageArea() noexcept
+{
+    if (mBegin) {
+        munmap(mBegin, mMapSize);
+    }
+}
+
+size_t decommitMemory(void *begin, void *end) noexcept
+{
+    const size_t pageSize = systemPageSize();
+    void *const first = pointer::align(begin, pageSize);
+    void *const last = (void *) (uintptr_t(end) & ~(pageSize - 1));
+    if (first >= last) {
+        return 0;
+    }
+    const size_t size = uintptr_t(last) - uintptr_t(first);
+#ifdef MADV_DONTNEED
+    madvise(first, size, MADV_DONTNEED);
+#else
+    posix_madvise(first, size, POSIX_MADV_DONTNEED);
+#endif
+    return size;
+}
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+
+namespace numa
+{
+
+#if GX_PLATFORM_WINDOWS
+
+uint32_t nodeCount() noexcept
+{
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) {
+        return 1;
+    }
+    return (uint32_t) highest + 1;
+}
+
+uint32_t currentNode() noexcept
+{
+    PROCESSOR_NUMBER processor;
+    GetCurrentProcessorNumberEx(&processor);
+    USHORT node = 0;
+    if (!GetNumaProcessorNodeEx(&processor, &node)) {
+        return 0;
+    }
+    return node;
+}
+
+bool preferNode(uint32_t) noexcept
+{
+    // No per thread policy, NumaArea allocates with VirtualAllocExNuma instead
+    return false;
+}
+
+bool bindMemory(void *, size_t, uint32_t) noexcept
+{
+    return false;
+}
+
+#elif GX_PLATFORM_LINUX
+
+#define NUMA_MPOL_PREFERRED 1
+#define NUMA_MAX_NODES 1024
+
+struct Topology
+{
+    uint32_t nodeCount = 1;
+    std::vector<uint16_t> cpuToNode;
+};
+
+/**
+ * Parse a sysfs cpu / node list such as "0-3,8-11".
+ */
+template<typename FUNC>
+static bool readIndexList(const char *path, FUNC &&func)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    char buffer[1024];
+    const bool ok = fgets(buffer, sizeof(buffer), file) != nullptr;
+    fclose(file);
+    if (!ok) {
+        return false;
+    }
+    const char *p = buffer;
+    while (*p >= '0' && *p <= '9') {
+        char *next;
+        const unsigned long first = strtoul(p, &next, 10);
+        unsigned long last = first;
+        if (*next == '-') {
+            last = strtoul(next + 1, &next, 10);
+        }
+        for (unsigned long i = first; i <= last; i++) {
+            func((uint32_t) i);
+        }
+        p = *next == ',' ? next + 1 : next;
+    }
+    return true;
+}
+
+static const Topology &topology()
+{
+    static const Topology sTopology = [] {
+        Topology topology;
+        uint32_t maxNode = 0;
+        if (!readIndexList("/sys/devices/system/node/online", [&](uint32_t node) {
+            maxNode = std::max(maxNode, node);
+        })) {
+            return topology;
+        }
+        topology.nodeCount = std::min<uint32_t>(maxNode + 1, NUMA_MAX_NODES);
+        if (topology.nodeCount == 1) {
+            return topology;
+        }
+        for (uint32_t node = 0; node < topology.nodeCount; node++) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+            readIndexList(path, [&](uint32_t cpu) {
+                if (cpu >= topology.cpuToNode.size()) {
+                    topology.cpuToNode.resize(cpu + 1, 0);
+                }
+                topology.cpuToNode[cpu] = (uint16_t) node;
+            });
+        }
+        return topology;
+    }();
+    return sTopology;
+}
+
+/**
+ * @brief set_mempolicy / mbind node mask with only node set.
+ */
+struct NodeMask
+{
+    unsigned long bits[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {};
+
+    explicit NodeMask(uint32_t node)
+    {
+        bits[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    }
+
+    static unsigned long maxNode()
+    {
+        return NUMA_MAX_NODES + 1;
+    }
+};
+
+uint32_t nodeCount() noexcept
+{
+    return topology().nodeCount;
+}
+
+uint32_t currentNode() noexcept
+{
+    const Topology &topo = topology();
+    if (topo.nodeCount == 1) {
+        return 0;
+    }
+    const int cpu = sched_getcpu();
+    if (cpu < 0 || (size_t) cpu >= topo.cpuToNode.size()) {
+        return 0;
+    }
+    return topo.cpuToNode[cpu];
+}
+
+bool preferNode(uint32_t node) noexcept
+{
+    if (node >= nodeCount()) {
+        return false;
+    }
+    const NodeMask mask(node);
+    return syscall(SYS_set_mempolicy, NUMA_MPOL_PREFERRED, mask.bits, NodeMask::maxNode()) == 0;
+}
+
+bool bindMemory(void *addr, size_t size, uint32_t node) noexcept
+{
+    if (node >= nodeCount()) {
+        return false;
+    }
+    const NodeMask mask(node);
+    return syscall(SYS_mbind, addr, size, NUMA_MPOL_PREFERRED, mask.bits, NodeMask::maxNode(), 0) == 0;
+}
+
+#else
+
+uint32_t nodeCount() noexcept
+{
+    return 1;
+}
+
+uint32_t currentNode() noexcept
+{
+    return 0;
+}
+
+bool preferNode(uint32_t) noexcept
+{
+    return false;
+}
+
+bool bindMemory(void *, size_t, uint32_t) noexcept
+{
+    return false;
+}
+
+#endif
+
+}
+
+#if GX_PLATFORM_WINDOWS
+
+NumaArea::NumaArea(size_t size, uint32_t node, bool populate)
+        : mNode(node)
+{
+    if (size == 0) {
+        return;
+    }
+    const size_t pageSize = systemPageSize();
+    const size_t mapSize = pointer::alignSize(size, pageSize);
+    void *p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, mapSize, MEM_RESERVE | MEM_COMMIT,
+                                 PAGE_READWRITE, node);
+    mBound = p != nullptr;
+    if (!p) {
+        p = VirtualAlloc(nullptr, mapSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (!p) {
+        LogE("NumaArea: VirtualAlloc(%zu) failed", mapSize);
+        return;
+    }
+    mBegin = p;
+    mEnd = pointer::add(p, size);
+    mMapSize = mapSize;
+
+    if (populate) {
+        for (size_t offset = 0; offset < mapSize; offset += pageSize) {
+            *((volatile char *) p + offset) = 0;
+        }
+    }
+}
+
+NumaArea::~NumaArea() noexcept
+{
+    if (mBegin) {
+        VirtualFree(mBegin, 0, MEM_RELEASE);
+    }
+}
+
+#else
+
+NumaArea::NumaArea(size_t size, uint32_t node, bool populate)
+        : mNode(node)
+{
+    if (size == 0) {
+        return;
+    }
+    int mapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    mapFlags |= MAP_NORESERVE;
+#endif
+    const size_t pageSize = systemPageSize();
+    const size_t mapSize = pointer::alignSize(size, pageSize);
+    void *p = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, mapFlags, -1, 0);
+    if (p == MAP_FAILED) {
+        LogE("NumaArea: mmap(%zu) failed", mapSize);
+        return;
+    }
+    // Nothing to bind with a single node, otherwise the pages follow the first touch
+    mBound = numa::nodeCount() > 1 && numa::bindMemory(p, mapSize, node);
+    mBegin = p;
+    mEnd = pointer::add(p, size);
+    mMapSize = mapSize;
+
+    if (populate) {
+        for (size_t offset = 0; offset < mapSize; offset += pageSize) {
+            *((volatile char *) p + offset) = 0;
+        }
+    }
+}
+
+NumaArea::~NumaArea() noexcept
+{
+    if (mBegin) {
+        munmap(mBegin, mMapSize);
+    }
+}
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+
+#if GX_PLATFORM_WINDOWS
+
+SharedMemoryArea::SharedMemoryArea(size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    mHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                 DWORD(uint64_t(size) >> 32), DWORD(size), nullptr);
+    if (!mHandle) {
+        LogE("SharedMemoryArea: CreateFileMapping(%zu) failed", size);
+        return;
+    }
+    mCreator = true;
+    map(size);
+}
+
+SharedMemoryArea::SharedMemoryArea(const char *name, size_t size, Mode mode)
+{
+    if (mode == Open || size == 0) {
+        mHandle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    } else {
+        mHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                     DWORD(uint64_t(size) >> 32), DWORD(size), name);
+        const bool exists = mHandle && GetLastError() == ERROR_ALREADY_EXISTS;
+        if (exists && mode == Create) {
+            CloseHandle(mHandle);
+            mHandle = nullptr;
+        }
+        mCreator = mHandle && !exists;
+    }
+    if (!mHandle) {
+        LogE("SharedMemoryArea: cannot open '%s'", name);
+        return;
+    }
+    map(mCreator ? size : 0);
+}
+
+SharedMemoryArea::SharedMemoryArea(NativeHandle handle, size_t size)
+{
+    if (!DuplicateHandle(GetCurrentProcess(), handle, GetCurrentProcess(), &mHandle,
+                         0, FALSE, DUPLICATE_SAME_ACCESS)) {
+        mHandle = nullptr;
+        LogE("SharedMemoryArea: DuplicateHandle failed");
+        return;
+    }
+    map(size);
+}
+
+SharedMemoryArea::~SharedMemoryArea() noexcept
+{
+    if (mBegin) {
+        UnmapViewOfFile(mBegin);
+    }
+    if (mHandle) {
+        CloseHandle(mHandle);
+    }
+}
+
+bool SharedMemoryArea::map(size_t size) noexcept
+{
+    void *const p = MapViewOfFile(mHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!p) {
+        LogE("SharedMemoryArea: MapViewOfFile(%zu) failed", size);
+        return false;
+    }
+    if (size == 0) {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(p, &info, sizeof(info));
+        size = info.RegionSize;
+    }
+    mBegin = p;
+    mEnd = pointer::add(p, size);
+    return true;
+}
+
+bool SharedMemoryArea::unlink(const char *) noexcept
+{
+    return true;
+}
+
+#else
+
+SharedMemoryArea::SharedMemoryArea(size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+#if GX_PLATFORM_LINUX && defined(SYS_memfd_create)
+    // MFD_CLOEXEC
+    mHandle = (int) syscall(SYS_memfd_create, "gx-shared-memory", 1u);
+#endif
+    if (mHandle < 0) {
+        // The object only has to exist until it is mapped, pick a unique name and unlink it at once
+        static std::atomic<uint32_t> sCounter{0};
+        char name[64];
+        snprintf(name, sizeof(name), "/gx-shm-%d-%u", (int) getpid(), sCounter.fetch_add(1));
+        mHandle = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (mHandle >= 0) {
+            shm_unlink(name);
+        }
+    }
+    if (mHandle < 0) {
+        LogE("SharedMemoryArea: cannot create a shared memory object");
+        return;
+    }
+    mCreator = true;
+    if (ftruncate(mHandle, (off_t) size) != 0) {
+        LogE("SharedMemoryArea: ftruncate(%zu) failed", size);
+        return;
+    }
+    map(size);
+}
+
+/**
+ * @brief The creator of a named object sizes it only after shm_open() returned,
+ * a process that opens the object meanwhile sees it empty and has to wait.
+ * @return Size of the object, 0 if it stays empty
+ */
+static size_t waitSharedMemorySize(int handle)
+{
+    const auto deadline = std::chrono::steady_clock::now() + details::SHARED_ATTACH_TIMEOUT;
+    for (;;) {
+        struct stat st{};
+        if (fstat(handle, &st) != 0) {
+            return 0;
+        }
+        if (st.st_size > 0) {
+            return (size_t) st.st_size;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+SharedMemoryArea::SharedMemoryArea(const char *name, size_t size, Mode mode)
+{
+    if (mode != Open && size) {
+        mHandle = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        mCreator = mHandle >= 0;
+    }
+    if (mHandle < 0 && mode != Create) {
+        mHandle = shm_open(name, O_RDWR, 0600);
+    }
+    if (mHandle < 0) {
+        LogE("SharedMemoryArea: cannot open '%s'", name);
+        return;
+    }
+    if (mCreator) {
+        if (ftruncate(mHandle, (off_t) size) != 0) {
+            LogE("SharedMemoryArea: ftruncate(%zu) failed", size);
+            return;
+        }
+    } else {
+        size = waitSharedMemorySize(mHandle);
+        if (size == 0) {
+            LogE("SharedMemoryArea: '%s' was never sized by its creator", name);
+            return;
+        }
+    }
+    map(size);
+}
+
+SharedMemoryArea::SharedMemoryArea(NativeHandle handle, size_t size)
+{
+    mHandle = fcntl(handle, F_DUPFD_CLOEXEC, 0);
+    if (mHandle < 0) {
+        LogE("SharedMemoryArea: cannot duplicate handle %d", handle);
+        return;
+    }
+    map(size);
+}
+
+SharedMemoryArea::~SharedMemoryArea() noexcept
+{
+    if (mBegin) {
+        munmap(mBegin, size());
+    }
+    if (mHandle >= 0) {
+        close(mHandle);
+    }
+}
+
+bool SharedMemoryArea::map(size_t size) noexcept
+{
+    if (size == 0) {
+        struct stat st{};
+        if (fstat(mHandle, &st) != 0 || st.st_size <= 0) {
+            LogE("SharedMemoryArea: cannot get the size of handle %d", mHandle);
+            return false;
+        }
+        size = (size_t) st.st_size;
+    }
+    void *const p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mHandle, 0);
+    if (p == MAP_FAILED) {
+        LogE("SharedMemoryArea: mmap(%zu) failed", size);
+        return false;
+    }
+    mBegin = p;
+    mEnd = pointer::add(p, size);
+    return true;
+}
+
+bool SharedMemoryArea::unlink(const char *name) noexcept
+{
+    return shm_unlink(name) == 0;
+}
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+
+#define ADAPTIVE_LOCK_MIN_SPIN 16
+#define ADAPTIVE_LOCK_MAX_SPIN 1024
+#define ADAPTIVE_LOCK_YIELD_COUNT 4
+
+static inline void cpuRelax()
+{
+#if defined(_MSC_VER)
+    YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void AdaptiveLock::lockSlow() noexcept
+{
+    mContendedCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Spinning cannot help when the owner is waiting for this cpu
+    static const bool sCanSpin = std::thread::hardware_concurrency() > 1;
+
+    if (sCanSpin) {
+        // Spin up to twice as long as contended acquisitions took on average
+        const uint32_t estimate = mSpinEstimate.load(std::memory_order_relaxed);
+        const uint32_t limit = std::min<uint32_t>(ADAPTIVE_LOCK_MAX_SPIN, estimate * 2 + ADAPTIVE_LOCK_MIN_SPIN);
+        for (uint32_t spin = 1; spin <= limit + ADAPTIVE_LOCK_YIELD_COUNT; spin++) {
+            if (spin <= limit) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+            uint32_t expected = UNLOCKED;
+            if (mState.load(std::memory_order_relaxed) == UNLOCKED &&
+                mState.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                mSpinEstimate.store(estimate + (int32_t(std::min(spin, limit)) - int32_t(estimate)) / 8,
+                                    std::memory_order_relaxed);
+                mSpinAcquireCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        mSpinEstimate.store(estimate + (int32_t(limit) - int32_t(estimate)) / 8, std::memory_order_relaxed);
+    }
+
+    // Mark the lock as having waiters, unlock() then wakes one of them
+    while (mState.exchange(LOCKED_WAITERS, std::memory_order_acquire) != UNLOCKED) {
+        mParkCount.fetch_add(1, std::memory_order_relaxed);
+        park();
+    }
+}
+
+#if GX_ADAPTIVE_LOCK_FUTEX
+
+void AdaptiveLock::park() noexcept
+{
+    // Returns at once if the state changed in between
+    syscall(SYS_futex, &mState, FUTEX_WAIT_PRIVATE, LOCKED_WAITERS, nullptr, nullptr, 0);
+}
+
+void AdaptiveLock::unpark() noexcept
+{
+    syscall(SYS_futex, &mState, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+#else
+
+void AdaptiveLock::park() noexcept
+{
+    std::unique_lock<std::mutex> locker(mParkMutex);
+    if (mState.load(std::memory_order_relaxed) == LOCKED_WAITERS) {
+        mParkCond.wait(locker);
+    }
+}
+
+void AdaptiveLock::unpark() noexcept
+{
+    // Taking the mutex orders the wake up after a waiter that saw LOCKED_WAITERS started waiting
+    { std::lock_guard<std::mutex> locker(mParkMutex); }
+    mParkCond.notify_one();
+}
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+
+ChainedLinearAllocator &ScratchArena::local() noexcept
+{
+    thread_local ChainedLinearAllocator arena(CHUNK_SIZE);
+    return arena;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+namespace TrackingPolicy
+{
+
+struct StatsRegistry
+{
+    GMutex lock;
+    std::vector<const Stats *> stats;
+};
+
+/// Never destroyed, ponds with static storage may unregister during exit
+static StatsRegistry &statsRegistry()
+{
+    static auto *registry = GX_NEW(StatsRegistry);
+    return *registry;
+}
+
+static void accumulate(PondStats &out, const PondStats &stats)
+{
+    out.currentBytes += stats.currentBytes;
+    out.peakBytes += stats.peakBytes;
+    out.allocCount += stats.allocCount;
+    out.freeCount += stats.freeCount;
+    out.failedCount += stats.failedCount;
+    for (size_t i = 0; i < PondStats::HISTOGRAM_SIZE; i++) {
+        out.histogram[i] += stats.histogram[i];
+    }
+}
+
+Stats::Stats(const char *name)
+        : mName(name ? name : "")
+{
+    StatsRegistry &registry = statsRegistry();
+    GLockerGuard locker(registry.lock);
+    registry.stats.push_back(this);
+}
+
+Stats::~Stats()
+{
+    const PondStats stats = snapshot();
+    if (stats.outstanding() > 0) {
+        LogW("Pond \"%s\" destroyed with %llu outstanding allocations (%llu bytes)",
+             mName, (unsigned long long) stats.outstanding(), (unsigned long long) stats.currentBytes);
+    }
+
+    StatsRegistry &registry = statsRegistry();
+    GLockerGuard locker(registry.lock);
+    registry.stats.erase(std::remove(registry.stats.begin(), registry.stats.end(), this), registry.stats.end());
+}
+
+PondStats Stats::snapshot() const noexcept
+{
+    PondStats stats;
+    stats.currentBytes = mCurrentBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = mPeakBytes.load(std::memory_order_relaxed);
+    stats.allocCount = mAllocCount.load(std::memory_order_relaxed);
+    stats.freeCount = mFreeCount.load(std::memory_order_relaxed);
+    stats.failedCount = mFailedCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < PondStats::HISTOGRAM_SIZE; i++) {
+        stats.histogram[i] = mHistogram[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void swap(Stats &lhs, Stats &rhs) noexcept
+{
+    auto swapAtomic = [](std::atomic<uint64_t> &a, std::atomic<uint64_t> &b) {
+        b.store(a.exchange(b.load(std::memory_order_relaxed), std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    std::swap(lhs.mName, rhs.mName);
+    swapAtomic(lhs.mCurrentBytes, rhs.mCurrentBytes);
+    swapAtomic(lhs.mPeakBytes, rhs.mPeakBytes);
+    swapAtomic(lhs.mAllocCount, rhs.mAllocCount);
+    swapAtomic(lhs.mFreeCount, rhs.mFreeCount);
+    swapAtomic(lhs.mFailedCount, rhs.mFailedCount);
+    for (size_t i = 0; i < PondStats::HISTOGRAM_SIZE; i++) {
+        swapAtomic(lhs.mHistogram[i], rhs.mHistogram[i]);
+    }
+}
+
+bool Stats::get(const char *name, PondStats &out)
+{
+    out = PondStats();
+    bool found = false;
+
+    StatsRegistry &registry = statsRegistry();
+    GLockerGuard locker(registry.lock);
+    for (const Stats *stats: registry.stats) {
+        if (strcmp(stats->mName, name) == 0) {
+            accumulate(out, stats->snapshot());
+            found = true;
+        }
+    }
+    return found;
+}
+
+void Stats::forEach(const std::function<void(const char *name, const PondStats &stats)> &visitor)
+{
+    StatsRegistry &registry = statsRegistry();
+    GLockerGuard locker(registry.lock);
+    for (const Stats *stats: registry.stats) {
+        visitor(stats->mName, stats->snapshot());
+    }
+}
+
+} // namespace TrackingPolicy
+
+GX_NS_END
@@ -81,7 +81,9 @@ GByteArray::GByteArray(const uint8_t *data, int32_t size)
     if (size < 0) {
         size = (int32_t) strlen((const char *) data) + 1;
     }
-    reset(size);
+    if (size > 0) {
+        mBufferRef = std::make_shared<BufferRef>(size, size);
+    }
     write(data, size);
 }
 
@@ -581,25 +583,27 @@ GByteArray GByteArray::base64Decode(const std::string &codes)
     return GByteArray(ret);
 }
 
+// The hash job and the digest stay on the stack, only the returned array is allocated
+static GByteArray hashSumOf(GHashSum::HashType hashType, const GByteArray &data)
+{
+    uint8_t digest[GHashSum::MAX_DIGEST_SIZE];
+    const uint32_t size = GHashSum::hashSum(hashType, data.data(), data.size(), digest, sizeof(digest));
+    return GByteArray(digest, (int32_t) size);
+}
+
 GByteArray GByteArray::md5Sum(const GByteArray &data)
 {
-    auto hashSum = GHashSum::hashSum(GHashSum::Md5);
-    hashSum->update(data);
-    return hashSum->final();
+    return hashSumOf(GHashSum::Md5, data);
 }
 
 GByteArray GByteArray::sha1Sum(const GByteArray &data)
 {
-    auto hashSum = GHashSum::hashSum(GHashSum::Sha1);
-    hashSum->update(data);
-    return hashSum->final();
+    return hashSumOf(GHashSum::Sha1, data);
 }
 
 GByteArray GByteArray::sha256Sum(const GByteArray &data)
 {
-    auto hashSum = GHashSum::hashSum(GHashSum::Sha256);
-    hashSum->update(data);
-    return hashSum->final();
+    return hashSumOf(GHashSum::Sha256, data);
 }
 
 
@@ -607,8 +611,14 @@ void GByteArray::resize(uint32_t size)
 {
     if (mBufferRef) {
         if (size > mBufferRef->size) {
-            copyOnWrite();
-            mBufferRef->resize(size);
+            if (mBufferRef.use_count() > 1) {
+                // Copy the shared buffer straight into the larger one
+                auto newBufferRef = std::make_shared<BufferRef>(size, mBufferRef->size);
+                memcpy(newBufferRef->buffer, mBufferRef->buffer, mBufferRef->size);
+                mBufferRef = newBufferRef;
+            } else {
+                mBufferRef->resize(size);
+            }
         }
     } else {
         mBufferRef = std::make_shared<BufferRef>(size);
@@ -648,16 +658,19 @@ void GByteArray::copyOnWrite()
         return;
     }
 
-    auto newBufferRef = std::make_shared<BufferRef>(mBufferRef->size);
+    auto newBufferRef = std::make_shared<BufferRef>(mBufferRef->size, mBufferRef->size);
     memcpy(newBufferRef->buffer, mBufferRef->buffer, mBufferRef->size);
 
     mBufferRef = newBufferRef;
 }
 
-GByteArray::BufferRef::BufferRef(uint32_t _size)
+GByteArray::BufferRef::BufferRef(uint32_t _size, uint32_t uninitialized)
 {
     size = _size;
-    buffer = (uint8_t *) GGlobalMemoryPool::alloc(size);
+    buffer = (uint8_t *) GGlobalMemoryPool::allocUninitialized(size);
+    if (uninitialized < size) {
+        memset(buffer + uninitialized, 0, size - uninitialized);
+    }
 }
 
 GByteArray::BufferRef::~BufferRef()
@@ -670,8 +683,9 @@ void GByteArray::BufferRef::resize(uint32_t newSize)
     if (newSize <= this->size) {
         return;
     }
-    auto *newBuffer = (uint8_t *) GGlobalMemoryPool::alloc(newSize);
-    memcpy(newBuffer, this->buffer, std::min(this->size, newSize));
+    auto *newBuffer = (uint8_t *) GGlobalMemoryPool::allocUninitialized(newSize);
+    memcpy(newBuffer, this->buffer, this->size);
+    memset(newBuffer + this->size, 0, newSize - this->size);
     GGlobalMemoryPool::free(this->buffer, this->size);
     this->buffer = newBuffer;
     this->size = newSize;
@@ -21,6 +21,7 @@
  */
 
 #include "gx/gcrypto.h"
+#include "gx/allocator.h"
 
 #include <gx/debug.h>
 
@@ -150,10 +151,14 @@ GX_NS_BEGIN
 
 GByteArray GCrypto::randomBytes(int32_t len)
 {
-    std::vector<uint8_t> data(len);
-    randombytes_(&data[0], len);
+    ScratchScope scope;
+    uint8_t *data = ScratchArena::alloc<uint8_t>(len);
+    if (!data) {
+        return GByteArray();
+    }
+    randombytes_(data, len);
 
-    GByteArray ret(data.data(), (int32_t) len);
+    GByteArray ret(data, (int32_t) len);
     return ret;
 }
 
@@ -180,10 +185,11 @@ GByteArray GCrypto::sign(const GByteArray &data, const GCrypto::CryptoSecKey &se
 
     unsigned long long smLen = n + 64;
 
-    std::vector<uint8_t> smBuff(smLen);
+    ScratchScope scope;
+    uint8_t *smBuff = ScratchArena::alloc<uint8_t>(smLen);
 
-    if (crypto_sign(smBuff.data(), &smLen, data.data(), n, secKey.data()) == 0) {
-        GByteArray sm(smBuff.data(), (int32_t)smLen);
+    if (smBuff && crypto_sign(smBuff, &smLen, data.data(), n, secKey.data()) == 0) {
+        GByteArray sm(smBuff, (int32_t)smLen);
         return sm;
     }
 
@@ -195,10 +201,11 @@ GByteArray GCrypto::signOpen(const GByteArray &data, const GCrypto::CryptoPubKey
     uint32_t smLen = data.size();
 
     unsigned long long mLen = std::max((uint64_t)0, (uint64_t)(smLen - 64));
-    std::vector<uint8_t> mBuff(smLen);
+    ScratchScope scope;
+    uint8_t *mBuff = ScratchArena::alloc<uint8_t>(smLen);
 
-    if (crypto_sign_open(mBuff.data(), &mLen, data.data(), smLen, pubKey.data()) == 0) {
-        GByteArray m(mBuff.data(), (int32_t)mLen);
+    if (mBuff && crypto_sign_open(mBuff, &mLen, data.data(), smLen, pubKey.data()) == 0) {
+        GByteArray m(mBuff, (int32_t)mLen);
         return m;
     }
 
@@ -227,20 +234,23 @@ GByteArray GCrypto::box(const GByteArray &data, const GByteArray &nonce, const G
 {
     GX_ASSERT(nonce.size() <= crypto_box_NONCEBYTES);
 
-    std::vector<uint8_t> dataBuff(crypto_box_ZEROBYTES + data.size());
-    std::fill(dataBuff.begin(), dataBuff.begin() + crypto_box_ZEROBYTES, 0);
-    memcpy(dataBuff.data() + crypto_box_ZEROBYTES, data.data(), data.size());
-
-    std::vector<uint8_t> nonceData(crypto_box_NONCEBYTES, 0);
-    memcpy(nonceData.data(), nonce.data(), nonce.size());
+    ScratchScope scope;
+    const size_t dataSize = crypto_box_ZEROBYTES + data.size();
+    uint8_t *dataBuff = ScratchArena::alloc<uint8_t>(dataSize);
+    // The cipher text is as long as the padded message
+    uint8_t *boxBuff = ScratchArena::alloc<uint8_t>(dataSize);
+    if (!dataBuff || !boxBuff) {
+        return GByteArray();
+    }
+    memset(dataBuff, 0, crypto_box_ZEROBYTES);
+    memcpy(dataBuff + crypto_box_ZEROBYTES, data.data(), data.size());
 
-    std::vector<uint8_t> boxBuff(crypto_box_BOXZEROBYTES + 16 + data.size(), 0);
+    uint8_t nonceData[crypto_box_NONCEBYTES] = {};
+    memcpy(nonceData, nonce.data(), nonce.size());
 
-    int rc = crypto_box(boxBuff.data(), dataBuff.data(), dataBuff.size(), nonceData.data(), bPubKey.data(), aSecKey.data());
+    int rc = crypto_box(boxBuff, dataBuff, dataSize, nonceData, bPubKey.data(), aSecKey.data());
     if (rc == 0) {
-        GByteArray box;
-        box.write(boxBuff.data() + crypto_box_BOXZEROBYTES, data.size() + 16); // +16
-        return box;
+        return GByteArray(boxBuff + crypto_box_BOXZEROBYTES, (int32_t) data.size() + 16); // +16
     }
 
     return GByteArray();
@@ -251,19 +261,26 @@ GByteArray GCrypto::boxOpen(const GByteArray &data, const GByteArray &nonce, con
 {
     GX_ASSERT(nonce.size() <= crypto_box_NONCEBYTES);
 
-    std::vector<uint8_t> boxBuff(crypto_box_BOXZEROBYTES + data.size(), 0);
-    memcpy(boxBuff.data() + crypto_box_BOXZEROBYTES, data.data(), data.size());
+    if (data.size() < 16) {
+        return GByteArray();
+    }
 
-    std::vector<uint8_t> nonceData(crypto_box_NONCEBYTES, 0);
-    memcpy(&nonceData[0], nonce.data(), nonce.size());
+    ScratchScope scope;
+    const size_t boxSize = crypto_box_BOXZEROBYTES + data.size();
+    uint8_t *boxBuff = ScratchArena::alloc<uint8_t>(boxSize);
+    uint8_t *unboxBuff = ScratchArena::alloc<uint8_t>(boxSize);
+    if (!boxBuff || !unboxBuff) {
+        return GByteArray();
+    }
+    memset(boxBuff, 0, crypto_box_BOXZEROBYTES);
+    memcpy(boxBuff + crypto_box_BOXZEROBYTES, data.data(), data.size());
 
-    std::vector<uint8_t> unboxBuff(crypto_box_ZEROBYTES + data.size(), 0);
+    uint8_t nonceData[crypto_box_NONCEBYTES] = {};
+    memcpy(nonceData, nonce.data(), nonce.size());
 
-    int rc = crypto_box_open(unboxBuff.data(), boxBuff.data(), boxBuff.size(), nonceData.data(), aPubKey.data(), bSecKey.data());
+    int rc = crypto_box_open(unboxBuff, boxBuff, boxSize, nonceData, aPubKey.data(), bSecKey.data());
     if (rc == 0) {
-        GByteArray unbox;
-        unbox.write(&unboxBuff[crypto_box_ZEROBYTES], data.size() - 16); // -16
-        return unbox;
+        return GByteArray(unboxBuff + crypto_box_ZEROBYTES, (int32_t) data.size() - 16); // -16
     }
 
     return GByteArray();
@@ -272,10 +289,10 @@ GByteArray GCrypto::boxOpen(const GByteArray &data, const GByteArray &nonce, con
 GCrypto::CryptoShareKey GCrypto::boxBefore(const GCrypto::CryptoPubKey &bPubKey,
                                            const GCrypto::CryptoSecKey &aSecKey)
 {
-    std::vector<uint8_t> sharedKey(32);
+    uint8_t sharedKey[crypto_box_BEFORENMBYTES];
 
-    if (crypto_box_beforenm(sharedKey.data(), bPubKey.data(), aSecKey.data()) == 0) {
-        GByteArray key(sharedKey.data(), 32);
+    if (crypto_box_beforenm(sharedKey, bPubKey.data(), aSecKey.data()) == 0) {
+        GByteArray key(sharedKey, crypto_box_BEFORENMBYTES);
         return key;
     }
 
@@ -286,20 +303,23 @@ GByteArray GCrypto::boxAfter(const GByteArray &data, const GByteArray &nonce, co
 {
     GX_ASSERT(nonce.size() <= crypto_box_NONCEBYTES);
 
-    std::vector<uint8_t> dataBuff(crypto_box_ZEROBYTES + data.size());
-    std::fill(dataBuff.begin(), dataBuff.begin() + crypto_box_ZEROBYTES, 0);
-    memcpy(dataBuff.data() + crypto_box_ZEROBYTES, data.data(), data.size());
-
-    std::vector<uint8_t> nonceData(crypto_box_NONCEBYTES, 0);
-    memcpy(nonceData.data(), nonce.data(), nonce.size());
+    ScratchScope scope;
+    const size_t dataSize = crypto_box_ZEROBYTES + data.size();
+    uint8_t *dataBuff = ScratchArena::alloc<uint8_t>(dataSize);
+    // The cipher text is as long as the padded message
+    uint8_t *boxBuff = ScratchArena::alloc<uint8_t>(dataSize);
+    if (!dataBuff || !boxBuff) {
+        return GByteArray();
+    }
+    memset(dataBuff, 0, crypto_box_ZEROBYTES);
+    memcpy(dataBuff + crypto_box_ZEROBYTES, data.data(), data.size());
 
-    std::vector<uint8_t> boxBuff(crypto_box_BOXZEROBYTES + 16 + data.size(), 0);
+    uint8_t nonceData[crypto_box_NONCEBYTES] = {};
+    memcpy(nonceData, nonce.data(), nonce.size());
 
-    int rc = crypto_box_afternm(boxBuff.data(), dataBuff.data(), dataBuff.size(), nonceData.data(), key.data());
+    int rc = crypto_box_afternm(boxBuff, dataBuff, dataSize, nonceData, key.data());
     if (rc == 0) {
-        GByteArray box;
-        box.write(boxBuff.data() + crypto_box_BOXZEROBYTES, data.size() + 16); // +16
-        return box;
+        return GByteArray(boxBuff + crypto_box_BOXZEROBYTES, (int32_t) data.size() + 16); // +16
     }
 
     return GByteArray();
@@ -310,19 +330,26 @@ GByteArray GCrypto::boxOpenAfter(const GByteArray &data, const GByteArray &nonce
 {
     GX_ASSERT(nonce.size() <= crypto_box_NONCEBYTES);
 
-    std::vector<uint8_t> boxBuff(crypto_box_BOXZEROBYTES + data.size(), 0);
-    memcpy(boxBuff.data() + crypto_box_BOXZEROBYTES, data.data(), data.size());
+    if (data.size() < 16) {
+        return GByteArray();
+    }
 
-    std::vector<uint8_t> nonceData(crypto_box_NONCEBYTES, 0);
-    memcpy(&nonceData[0], nonce.data(), nonce.size());
+    ScratchScope scope;
+    const size_t boxSize = crypto_box_BOXZEROBYTES + data.size();
+    uint8_t *boxBuff = ScratchArena::alloc<uint8_t>(boxSize);
+    uint8_t *unboxBuff = ScratchArena::alloc<uint8_t>(boxSize);
+    if (!boxBuff || !unboxBuff) {
+        return GByteArray();
+    }
+    memset(boxBuff, 0, crypto_box_BOXZEROBYTES);
+    memcpy(boxBuff + crypto_box_BOXZEROBYTES, data.data(), data.size());
 
-    std::vector<uint8_t> unboxBuff(crypto_box_ZEROBYTES + data.size(), 0);
+    uint8_t nonceData[crypto_box_NONCEBYTES] = {};
+    memcpy(nonceData, nonce.data(), nonce.size());
 
-    int rc = crypto_box_open_afternm(unboxBuff.data(), boxBuff.data(), boxBuff.size(), nonceData.data(), key.data());
+    int rc = crypto_box_open_afternm(unboxBuff, boxBuff, boxSize, nonceData, key.data());
     if (rc == 0) {
-        GByteArray unbox;
-        unbox.write(&unboxBuff[crypto_box_ZEROBYTES], data.size() - 16); // -16
-        return unbox;
+        return GByteArray(unboxBuff + crypto_box_ZEROBYTES, (int32_t) data.size() - 16); // -16
     }
 
     return GByteArray();
@@ -21,6 +21,7 @@
  */
 
 #include "gx/gfile.h"
+#include "gx/allocator.h"
 
 #include <sys/stat.h>
 #include <fstream>
@@ -517,24 +518,32 @@ GString GFile::readAll()
 
 GString GFile::readLine()
 {
-    int64_t bufferSize = 1024;
-    char *buffer = (char *) malloc(bufferSize);
+    ScratchScope scope;
+    size_t bufferSize = 1024;
+    char *buffer = ScratchArena::alloc<char>(bufferSize);
+    if (!buffer) {
+        return GString();
+    }
 
-    int64_t len = 0;
-    char c;
+    size_t len = 0;
+    int c;
     while ((c = fgetc(mFilePtr)) != EOF && c != '\0' && c != '\n') {
-        if (len >= bufferSize) {
-            bufferSize = len + 64;
-            buffer = (char *) realloc(buffer, bufferSize);
+        // Keep room for the terminator, the old buffer is released with the scope
+        if (len + 1 >= bufferSize) {
+            char *const grown = ScratchArena::alloc<char>(bufferSize * 2);
+            if (!grown) {
+                break;
+            }
+            memcpy(grown, buffer, len);
+            buffer = grown;
+            bufferSize *= 2;
         }
-        buffer[len++] = c;
+        buffer[len++] = (char) c;
     }
 
     buffer[len] = '\0';
 
-    GString str(buffer);
-    free(buffer);
-    return str;
+    return GString(buffer);
 }
 
 bool GFile::atEnd()
@@ -22,24 +22,218 @@
 
 #include "gx/gglobal_memory_pool.h"
 
+#include "gx/gtimer.h"
+
 #include <memory>
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/// Size classes up to this size get a preallocated slab, larger classes grow on demand
+#define POOL_SMALL_CLASS_SIZE 1024
+#define POOL_SMALL_PRE_ALLOC_SIZE (16 * 1024)
+#define POOL_8K_PRE_ALLOC_SIZE (8 * 1024 * 32)
+#define POOL_64K_PRE_ALLOC_SIZE (64 * 1024 * 16)
 
+/// Bytes each thread may cache over all size classes, split evenly between the classes,
+/// and the bounds of a magazine
+#define THREAD_CACHE_SIZE (1024 * 1024)
+#define THREAD_CACHE_MIN_COUNT 2
+#define THREAD_CACHE_MAX_COUNT 64
 
-#define POOL_S_PRE_ALLOC_SIZE (ELEMENT_S_SIZE * 32)
-#define POOL_M_PRE_ALLOC_SIZE (ELEMENT_M_SIZE * 16)
+/// Fill uninitialized blocks with a pattern
+#ifndef GX_MEMORY_POOL_POISON
+#if GX_DEBUG
+#define GX_MEMORY_POOL_POISON 1
+#else
+#define GX_MEMORY_POOL_POISON 0
+#endif
+#endif
+#define POOL_POISON_BYTE 0xCD
+
+/// Default trim policy
+#define POOL_TRIM_DECAY_MS 10000
+#define POOL_TRIM_LOW_WATERMARK (1024 * 1024)
+#define POOL_TRIM_HIGH_WATERMARK (64 * 1024 * 1024)
 
 GX_NS_BEGIN
 
+static inline uint32_t highestBit(uint32_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, v);
+    return (uint32_t) index;
+#else
+    return 31 - (uint32_t) __builtin_clz(v);
+#endif
+}
+
+/**
+ * @brief A stack of free blocks owned by one thread.
+ * Only the owner thread modifies it, count is atomic so that statistics can be read from other threads.
+ */
+struct Magazine
+{
+    void *blocks[THREAD_CACHE_MAX_COUNT];
+    uint32_t capacity = THREAD_CACHE_MIN_COUNT;
+    std::atomic<uint32_t> count{0};
+
+    void *pop() noexcept
+    {
+        const uint32_t n = count.load(std::memory_order_relaxed);
+        if (n == 0) {
+            return nullptr;
+        }
+        count.store(n - 1, std::memory_order_relaxed);
+        return blocks[n - 1];
+    }
+
+    bool push(void *p) noexcept
+    {
+        const uint32_t n = count.load(std::memory_order_relaxed);
+        if (n == capacity) {
+            return false;
+        }
+        blocks[n] = p;
+        count.store(n + 1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+/**
+ * @brief Take a block from the magazine, refill half of the magazine from the shared pool when it is empty.
+ */
+template<typename POND>
+static void *magazineAlloc(Magazine &magazine, POND &pond)
+{
+    void *p = magazine.pop();
+    if (p) {
+        return p;
+    }
+    const size_t count = pond.allocBatch(magazine.blocks, magazine.capacity / 2);
+    magazine.count.store((uint32_t) count, std::memory_order_relaxed);
+    return magazine.pop();
+}
+
+/**
+ * @brief Put a block into the magazine, when it is full, the colder half is returned to the shared pool.
+ * Blocks freed by a thread other than the allocating one end up here, the overflow keeps them flowing
+ * back to the shared pool instead of piling up in the freeing thread.
+ */
+template<typename POND>
+static void magazineFree(Magazine &magazine, POND &pond, void *ptr)
+{
+    if (magazine.push(ptr)) {
+        return;
+    }
+    const uint32_t capacity = magazine.capacity;
+    const uint32_t half = capacity / 2;
+    pond.freeBatch(magazine.blocks, half);
+    std::copy(magazine.blocks + half, magazine.blocks + capacity, magazine.blocks);
+    magazine.count.store(capacity - half, std::memory_order_relaxed);
+    magazine.push(ptr);
+}
+
+template<typename POND>
+static void magazineFlush(Magazine &magazine, POND &pond)
+{
+    pond.freeBatch(magazine.blocks, magazine.count.load(std::memory_order_relaxed));
+    magazine.count.store(0, std::memory_order_relaxed);
+}
+
+struct GGlobalMemoryPool::ThreadCache
+{
+    explicit ThreadCache(GGlobalMemoryPool *pool)
+            : pool(pool),
+              flushEpoch(pool->mFlushEpoch.load(std::memory_order_relaxed))
+    {
+        uint64_t cacheSize = 0;
+        for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+            const uint32_t count = THREAD_CACHE_SIZE / SIZE_CLASS_COUNT / sizeClassSize(i);
+            magazines[i].capacity = std::clamp<uint32_t>(count, THREAD_CACHE_MIN_COUNT, THREAD_CACHE_MAX_COUNT);
+            cacheSize += (uint64_t) magazines[i].capacity * sizeClassSize(i);
+        }
+        // The minimum count of the largest classes must not push a full cache over the limit
+        GX_ASSERT(cacheSize <= THREAD_CACHE_SIZE);
+        (void) cacheSize;
+        GLockerGuard locker(pool->mCacheLock);
+        pool->mThreadCaches.push_back(this);
+    }
+
+    ~ThreadCache()
+    {
+        pool->releaseCache(this);
+    }
+
+    void flush()
+    {
+        for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+            magazineFlush(magazines[i], *pool->mClassPonds[i]);
+        }
+    }
+
+    uint64_t cachedSize() const
+    {
+        uint64_t size = 0;
+        for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+            size += (uint64_t) magazines[i].count.load(std::memory_order_relaxed) * sizeClassSize(i);
+        }
+        return size;
+    }
+
+    GGlobalMemoryPool *pool;
+    Magazine magazines[SIZE_CLASS_COUNT];
+
+    /// Last flush request of the pool honored by this cache
+    uint64_t flushEpoch;
+
+    /// Written only by the owner thread, may wrap when this thread frees blocks allocated elsewhere
+    std::atomic<uint64_t> allocatedSize{0};
+};
+
+/// Set once the thread cache of the current thread has been destroyed,
+/// later calls during thread exit go straight to the shared pools.
+static thread_local bool tCacheReleased = false;
+
+/// Pond only keeps the name pointer
+static char sClassPondNames[GGlobalMemoryPool::SIZE_CLASS_COUNT][32];
+
 GGlobalMemoryPool::GGlobalMemoryPool()
         : mHeapAlloc("GlobalHeapAlloc"),
-          mPoolAllocS("GlobalPoolAllocS", POOL_S_PRE_ALLOC_SIZE),
-          mPoolAllocM("GlobalPoolAllocM", POOL_M_PRE_ALLOC_SIZE)
+          mTrimDecay(POOL_TRIM_DECAY_MS),
+          mTrimLowWatermark(POOL_TRIM_LOW_WATERMARK),
+          mTrimHighWatermark(POOL_TRIM_HIGH_WATERMARK)
 {
+    for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        const uint32_t size = sizeClassSize(i);
+        size_t preAllocSize = 0;
+        if (size <= POOL_SMALL_CLASS_SIZE) {
+            preAllocSize = POOL_SMALL_PRE_ALLOC_SIZE;
+        } else if (size == 8 * 1024) {
+            preAllocSize = POOL_8K_PRE_ALLOC_SIZE;
+        } else if (size == MAX_CLASS_SIZE) {
+            preAllocSize = POOL_64K_PRE_ALLOC_SIZE;
+        }
+        snprintf(sClassPondNames[i], sizeof(sClassPondNames[i]), "GlobalPoolAlloc%u", size);
+        // Blocks keep the max_align_t alignment of malloc, except the 24 bytes class that can only give 8
+        const size_t alignment = std::min<size_t>(alignof(std::max_align_t), size & (~size + 1));
+        mClassPonds[i] = std::make_unique<ClassPond>(sClassPondNames[i], preAllocSize, size, alignment);
+    }
 }
 
 void *GGlobalMemoryPool::alloc(uint32_t &size)
 {
-    return getInstance()->_alloc(size);
+    return getInstance()->_alloc(size, true);
+}
+
+void *GGlobalMemoryPool::allocUninitialized(uint32_t &size)
+{
+    return getInstance()->_alloc(size, false);
 }
 
 void GGlobalMemoryPool::free(void *ptr, uint32_t size)
@@ -67,28 +261,116 @@ uint64_t GGlobalMemoryPool::poolSize()
     return getInstance()->_poolSize();
 }
 
+LockStats GGlobalMemoryPool::lockStats()
+{
+    return getInstance()->_lockStats();
+}
+
+void GGlobalMemoryPool::setTrimPolicy(int64_t decayMs, uint64_t lowWatermark, uint64_t highWatermark)
+{
+    getInstance()->_setTrimPolicy(decayMs, lowWatermark, highWatermark);
+}
+
+uint64_t GGlobalMemoryPool::trim()
+{
+    return getInstance()->_trim();
+}
+
+void GGlobalMemoryPool::startAutoTrim(const std::shared_ptr<GTimerScheduler> &scheduler)
+{
+    getInstance()->_startAutoTrim(scheduler);
+}
+
+void GGlobalMemoryPool::stopAutoTrim()
+{
+    getInstance()->_stopAutoTrim();
+}
+
 GGlobalMemoryPool *GGlobalMemoryPool::getInstance()
 {
     static auto *instance = GX_NEW(GGlobalMemoryPool);
     return instance;
 }
 
-void *GGlobalMemoryPool::_alloc(uint32_t &size)
+GGlobalMemoryPool::ThreadCache *GGlobalMemoryPool::localCache()
+{
+    if (tCacheReleased) {
+        return nullptr;
+    }
+    thread_local ThreadCache cache(this);
+
+    // trim() and gc() ask every thread to give its cached blocks back, each one does on its next alloc or free
+    const uint64_t epoch = mFlushEpoch.load(std::memory_order_relaxed);
+    if (cache.flushEpoch != epoch) {
+        cache.flushEpoch = epoch;
+        cache.flush();
+    }
+    return &cache;
+}
+
+void GGlobalMemoryPool::releaseCache(ThreadCache *cache)
+{
+    tCacheReleased = true;
+    cache->flush();
+
+    GLockerGuard locker(mCacheLock);
+    mAllocatedSize += cache->allocatedSize.load(std::memory_order_relaxed);
+    mThreadCaches.erase(std::remove(mThreadCaches.begin(), mThreadCaches.end(), cache), mThreadCaches.end());
+}
+
+/**
+ * Classes: 16, then 1.5 * 2^k and 2^(k+1) for every 2^k in [16, 32K].
+ */
+uint32_t GGlobalMemoryPool::sizeClassIndex(uint32_t size)
+{
+    if (size <= MIN_CLASS_SIZE) {
+        return 0;
+    }
+    const uint32_t v = size - 1;
+    const uint32_t k = highestBit(v);
+    const uint32_t upperHalf = (v >> (k - 1)) & 1;
+    return 1 + (k - 4) * 2 + upperHalf;
+}
+
+uint32_t GGlobalMemoryPool::sizeClassSize(uint32_t index)
+{
+    if (index == 0) {
+        return MIN_CLASS_SIZE;
+    }
+    const uint32_t k = (index - 1) / 2 + 4;
+    return (index - 1) % 2 ? (2u << k) : (3u << (k - 1));
+}
+
+void *GGlobalMemoryPool::_alloc(uint32_t &size, bool zeroFill)
 {
+    ThreadCache *cache = localCache();
     void *buffer;
-    if (size <= ELEMENT_S_SIZE) { // <= 8k
-        size = ELEMENT_S_SIZE;
-        buffer = mPoolAllocS.alloc(size, alignof(uint8_t));
-    } else if (size <= ELEMENT_M_SIZE) { // > 8k and <= 64k
-        size = ELEMENT_M_SIZE;
-        buffer = mPoolAllocM.alloc(size, alignof(uint8_t));
+    if (size <= MAX_CLASS_SIZE) {
+        const uint32_t index = sizeClassIndex(size);
+        ClassPond &pond = *mClassPonds[index];
+        size = sizeClassSize(index);
+        buffer = cache
+                 ? magazineAlloc(cache->magazines[index], pond)
+                 : pond.alloc(size, alignof(uint8_t));
     } else { // > 64k
         buffer = mHeapAlloc.alloc(size, alignof(uint8_t));
     }
     if (buffer) {
-        memset(buffer, 0, size);
+        if (zeroFill) {
+            memset(buffer, 0, size);
+        }
+#if GX_MEMORY_POOL_POISON
+        else {
+            memset(buffer, POOL_POISON_BYTE, size);
+        }
+#endif
+    }
+    if (cache) {
+        const uint64_t allocated = cache->allocatedSize.load(std::memory_order_relaxed);
+        cache->allocatedSize.store(allocated + size, std::memory_order_relaxed);
+    } else {
+        mAllocatedSize += (uint64_t) size;
     }
-    mAllocatedSize += (uint64_t) size;
     return buffer;
 }
 
@@ -97,35 +379,157 @@ void GGlobalMemoryPool::_free(void *ptr, uint32_t size)
     if (!ptr || size == 0) {
         return;
     }
-    if (size <= ELEMENT_S_SIZE) { // <= 8k
-        mPoolAllocS.free(ptr);
-    } else if (size <= ELEMENT_M_SIZE) { // > 8k and <= 64k
-        mPoolAllocM.free(ptr);
+    ThreadCache *cache = localCache();
+    if (size <= MAX_CLASS_SIZE) {
+        const uint32_t index = sizeClassIndex(size);
+        GX_ASSERT(sizeClassSize(index) == size);
+        ClassPond &pond = *mClassPonds[index];
+        if (cache) {
+            magazineFree(cache->magazines[index], pond, ptr);
+        } else {
+            pond.free(ptr);
+        }
     } else { // > 64k
         mHeapAlloc.free(ptr);
     }
-    mAllocatedSize -= (uint64_t) size;
+    if (cache) {
+        const uint64_t allocated = cache->allocatedSize.load(std::memory_order_relaxed);
+        cache->allocatedSize.store(allocated - size, std::memory_order_relaxed);
+    } else {
+        mAllocatedSize -= (uint64_t) size;
+    }
 }
 
 void GGlobalMemoryPool::_gc()
 {
-    mPoolAllocS.reset();
-    mPoolAllocM.reset();
+    // Only the calling thread's cache can be flushed here, the other threads flush on their next alloc or free
+    mFlushEpoch.fetch_add(1, std::memory_order_relaxed);
+    localCache();
+    for (auto &pond: mClassPonds) {
+        pond->reset();
+    }
 }
 
 uint64_t GGlobalMemoryPool::_allocatedSize()
 {
-    return mAllocatedSize.load();
+    GLockerGuard locker(mCacheLock);
+    uint64_t size = mAllocatedSize.load();
+    for (ThreadCache *cache: mThreadCaches) {
+        size += cache->allocatedSize.load(std::memory_order_relaxed);
+    }
+    return size;
 }
 
 uint64_t GGlobalMemoryPool::_poolCapacity()
 {
-    return mPoolAllocS.capacity() + mPoolAllocM.capacity();
+    uint64_t capacity = 0;
+    for (auto &pond: mClassPonds) {
+        capacity += pond->capacity();
+    }
+    return capacity;
 }
 
 uint64_t GGlobalMemoryPool::_poolSize()
 {
-    return mPoolAllocS.size() + mPoolAllocM.size();
+    // Blocks sitting in thread caches are still free from the user's point of view
+    uint64_t cachedSize = 0;
+    {
+        GLockerGuard locker(mCacheLock);
+        for (ThreadCache *cache: mThreadCaches) {
+            cachedSize += cache->cachedSize();
+        }
+    }
+    uint64_t poolSize = 0;
+    for (auto &pond: mClassPonds) {
+        poolSize += pond->size();
+    }
+    return poolSize > cachedSize ? poolSize - cachedSize : 0;
+}
+
+LockStats GGlobalMemoryPool::_lockStats()
+{
+    LockStats stats;
+    for (auto &pond: mClassPonds) {
+        const LockStats classStats = pond->getLock().stats();
+        stats.acquireCount += classStats.acquireCount;
+        stats.contendedCount += classStats.contendedCount;
+        stats.spinAcquireCount += classStats.spinAcquireCount;
+        stats.parkCount += classStats.parkCount;
+    }
+    return stats;
+}
+
+void GGlobalMemoryPool::_setTrimPolicy(int64_t decayMs, uint64_t lowWatermark, uint64_t highWatermark)
+{
+    GX_ASSERT(decayMs > 0);
+    GX_ASSERT(lowWatermark <= highWatermark);
+    GLockerGuard locker(mTrimLock);
+    mTrimDecay = decayMs;
+    mTrimLowWatermark = lowWatermark;
+    mTrimHighWatermark = highWatermark;
+    if (mTrimTimer) {
+        mTrimTimer->start(mTrimDecay);
+    }
+}
+
+/**
+ * Each pool keeps the lowest count of free blocks seen since the previous trim,
+ * that many blocks stayed free for the whole period and can be released.
+ */
+uint64_t GGlobalMemoryPool::_trim()
+{
+    // Blocks cached by the threads flow back to the pools as the threads honor this request,
+    // blocks that then stay free are released by a following trim()
+    mFlushEpoch.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t lowWatermark, highWatermark;
+    {
+        GLockerGuard locker(mTrimLock);
+        lowWatermark = mTrimLowWatermark;
+        highWatermark = mTrimHighWatermark;
+    }
+
+    uint64_t freeSize = 0;
+    for (auto &pond: mClassPonds) {
+        freeSize += pond->lockedCall([](DynamicPoolAllocator &allocator) {
+            return allocator.freeSize();
+        });
+    }
+    // Over the high watermark, release blocks regardless of their age
+    const bool idleOnly = freeSize <= highWatermark;
+    uint64_t budget = freeSize > lowWatermark ? freeSize - lowWatermark : 0;
+
+    // Larger classes first, they give back the most per block, classes under two pages give back nothing.
+    // Every pond is visited, so that all of them start a new idle period.
+    // The budget shrinks by the bytes actually decommitted.
+    uint64_t released = 0;
+    for (int32_t i = SIZE_CLASS_COUNT - 1; i >= 0; i--) {
+        const size_t size = mClassPonds[i]->lockedCall([budget, idleOnly](DynamicPoolAllocator &allocator) {
+            return allocator.purge(budget, idleOnly);
+        });
+        budget -= std::min<uint64_t>(budget, size);
+        released += size;
+    }
+    return released;
+}
+
+void GGlobalMemoryPool::_startAutoTrim(const std::shared_ptr<GTimerScheduler> &scheduler)
+{
+    GLockerGuard locker(mTrimLock);
+    mTrimTimer = std::make_shared<GTimer>(scheduler);
+    mTrimTimer->timerEvent([this] {
+        _trim();
+    });
+    mTrimTimer->start(mTrimDecay);
+}
+
+void GGlobalMemoryPool::_stopAutoTrim()
+{
+    GLockerGuard locker(mTrimLock);
+    if (mTrimTimer) {
+        mTrimTimer->stop();
+        mTrimTimer.reset();
+    }
 }
 
-GX_NS_END
\ No newline at end of file
+GX_NS_END
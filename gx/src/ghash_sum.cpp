@@ -57,6 +57,15 @@ public:
         return GByteArray(digest, MD5_BLOCK_SIZE);
     }
 
+    uint32_t final(uint8_t *digest, uint32_t size) override
+    {
+        if (size < MD5_BLOCK_SIZE) {
+            return 0;
+        }
+        fMD5Final(&mContext, digest);
+        return MD5_BLOCK_SIZE;
+    }
+
 private:
     Md5Context mContext{};
 };
@@ -89,6 +98,15 @@ public:
         return GByteArray(digest, SHA1_BLOCK_SIZE);
     }
 
+    uint32_t final(uint8_t *digest, uint32_t size) override
+    {
+        if (size < SHA1_BLOCK_SIZE) {
+            return 0;
+        }
+        fSHA1Final(&mContext, digest);
+        return SHA1_BLOCK_SIZE;
+    }
+
 private:
     SHA1Context mContext{};
 };
@@ -121,11 +139,28 @@ public:
         return GByteArray(digest, SHA256_BLOCK_SIZE);
     }
 
+    uint32_t final(uint8_t *digest, uint32_t size) override
+    {
+        if (size < SHA256_BLOCK_SIZE) {
+            return 0;
+        }
+        fSHA256Final(&mContext, digest);
+        return SHA256_BLOCK_SIZE;
+    }
+
 private:
     SHA256Context mContext{};
 };
 
 
+template<typename JOB>
+static uint32_t hashOnce(const uint8_t *data, uint32_t size, uint8_t *digest, uint32_t digestSize)
+{
+    JOB job;
+    job.update(data, size);
+    return job.final(digest, digestSize);
+}
+
 std::unique_ptr<GHashJob> GHashSum::hashSum(GHashSum::HashType hashType)
 {
     switch (hashType) {
@@ -139,4 +174,34 @@ std::unique_ptr<GHashJob> GHashSum::hashSum(GHashSum::HashType hashType)
     return nullptr;
 }
 
+uint32_t GHashSum::hashSum(GHashSum::HashType hashType, const uint8_t *data, uint32_t size,
+                           uint8_t *digest, uint32_t digestSize)
+{
+    switch (hashType) {
+        case Md5:
+            return hashOnce<Md5HashJob>(data, size, digest, digestSize);
+        case Sha1:
+            return hashOnce<Sha1Job>(data, size, digest, digestSize);
+        case Sha256:
+            return hashOnce<Sha256Job>(data, size, digest, digestSize);
+    }
+    return 0;
+}
+
+uint32_t GHashSum::digestSize(GHashSum::HashType hashType)
+{
+    switch (hashType) {
+        case Md5:
+            return MD5_BLOCK_SIZE;
+        case Sha1:
+            return SHA1_BLOCK_SIZE;
+        case Sha256:
+            return SHA256_BLOCK_SIZE;
+    }
+    return 0;
+}
+
+static_assert(SHA256_BLOCK_SIZE <= GHashSum::MAX_DIGEST_SIZE && SHA1_BLOCK_SIZE <= GHashSum::MAX_DIGEST_SIZE &&
+              MD5_BLOCK_SIZE <= GHashSum::MAX_DIGEST_SIZE, "GHashSum::MAX_DIGEST_SIZE is too small");
+
 GX_NS_END
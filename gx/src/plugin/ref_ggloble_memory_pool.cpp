@@ -23,6 +23,7 @@
 #include "ref_gx.h"
 
 #include <gx/gglobal_memory_pool.h>
+#include <gx/gtimer.h>
 
 
 GX_NS_BEGIN
@@ -35,7 +36,16 @@ void refGGlobalMemoryPool()
             })
             .staticFunc("allocatedSize", &GGlobalMemoryPool::allocatedSize)
             .staticFunc("poolCapacity", &GGlobalMemoryPool::poolCapacity)
-            .staticFunc("poolSize", &GGlobalMemoryPool::poolSize);
+            .staticFunc("poolSize", &GGlobalMemoryPool::poolSize)
+            .staticFunc("setTrimPolicy", &GGlobalMemoryPool::setTrimPolicy)
+            .staticFunc("trim", &GGlobalMemoryPool::trim)
+            .staticFunc("startAutoTrim", [](const std::shared_ptr<GTimerScheduler> &scheduler) {
+                GGlobalMemoryPool::startAutoTrim(scheduler);
+            })
+            .staticFunc("startAutoTrim", []() {
+                GGlobalMemoryPool::startAutoTrim();
+            })
+            .staticFunc("stopAutoTrim", &GGlobalMemoryPool::stopAutoTrim);
 }
 
 GX_NS_END
\ No newline at end of file
@@ -139,11 +139,18 @@ void refTaskSystem()
                  }, "Whether the task is valid. If it is canceled or got, the task will be invalid.")
             .func("subscribe", [](TaskSystem::Task<GAny> &self, const GAny &action) {
                 if (action.isFunction()) {
+                    // A null scheduler would run the action inline on the worker, skip it instead
+                    GTimerSchedulerPtr scheduler = GTimerScheduler::global();
+                    if (!scheduler) {
+                        LogE("Task.subscribe: no global scheduler, the action is not called.");
+                        return;
+                    }
                     self.subscribe([action](const GAny &ret) {
                         action(ret);
-                    });
+                    }, scheduler);
                 }
-            }, "Subscribe to tasks and return results by specifying the scheduler thread. "
+            }, "Subscribe to tasks and return results on the global scheduler thread, "
+               "nothing is delivered when there is no global scheduler. "
                "arg1: action, function(GAny ret).")
             .func("subscribe", [](TaskSystem::Task<GAny> &self, const GAny &action, const GTimerSchedulerPtr &scheduler) {
                 if (action.isFunction()) {
@@ -27,14 +27,232 @@
 #include "gx/gthread.h"
 #include "gx/debug.h"
 
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
 
 
 GX_NS_BEGIN
 
-TaskSystem::TaskSystem(uint32_t threadCount, std::string name)
+namespace details
+{
+
+void TaskStateBase::wait()
+{
+    if (isReady()) {
+        return;
+    }
+    GLocker<GMutex> locker(mLock);
+    mCond.wait(locker, [this] {
+        return isReady();
+    });
+}
+
+bool TaskStateBase::waitFor(int64_t ms)
+{
+    if (isReady()) {
+        return true;
+    }
+    GLocker<GMutex> locker(mLock);
+    return mCond.wait_for(locker, std::chrono::milliseconds(ms), [this] {
+        return isReady();
+    });
+}
+
+void TaskStateBase::onComplete(std::function<void()> func)
+{
+    {
+        GLockerGuard locker(mLock);
+        if (!isReady()) {
+            mContinuations.push_back(std::move(func));
+            return;
+        }
+    }
+    func();
+}
+
+void TaskStateBase::setError(std::exception_ptr error)
+{
+    mError = std::move(error);
+    complete();
+}
+
+void TaskStateBase::abandon()
+{
+    setError(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+}
+
+void TaskStateBase::complete()
+{
+    std::vector<std::function<void()>> continuations;
+    {
+        GLockerGuard locker(mLock);
+        GX_ASSERT_S(!isReady(), "Task completed twice");
+        mReady.store(true, std::memory_order_release);
+        continuations.swap(mContinuations);
+    }
+    mCond.notify_all();
+    for (auto &func: continuations) {
+        func();
+    }
+}
+
+}
+
+/**
+ * Chase-Lev work stealing deque ("Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013).
+ * The owner pushes and takes at the bottom, other threads steal from the top.
+ * The ring grows when full, retired rings are kept until the deque is destroyed,
+ * since a thief may still read from them.
+ */
+class TaskDeque
+{
+public:
+    using Item = void *;
+
+    explicit TaskDeque(int64_t capacity = 256)
+    {
+        mRing.store(newRing(capacity), std::memory_order_relaxed);
+    }
+
+    ~TaskDeque()
+    {
+        delete mRing.load(std::memory_order_relaxed);
+        for (Ring *ring: mRetired) {
+            delete ring;
+        }
+    }
+
+    TaskDeque(const TaskDeque &) = delete;
+
+    TaskDeque &operator=(const TaskDeque &) = delete;
+
+public:
+    /// Owner only
+    void push(Item item)
+    {
+        const int64_t b = mBottom.load(std::memory_order_relaxed);
+        const int64_t t = mTop.load(std::memory_order_acquire);
+        Ring *ring = mRing.load(std::memory_order_relaxed);
+        if (b - t > ring->capacity - 1) {
+            ring = grow(ring, t, b);
+        }
+        ring->at(b).store(item, std::memory_order_relaxed);
+        mBottom.store(b + 1, std::memory_order_release);
+    }
+
+    /// Owner only, newest first
+    Item take()
+    {
+        const int64_t b = mBottom.load(std::memory_order_relaxed) - 1;
+        Ring *const ring = mRing.load(std::memory_order_relaxed);
+        mBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = mTop.load(std::memory_order_relaxed);
+
+        Item item = nullptr;
+        if (t <= b) {
+            item = ring->at(b).load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last item, race against the thieves
+                if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                mBottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            mBottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /// Any thread, oldest first. May fail spuriously when racing with another thief
+    Item steal()
+    {
+        int64_t t = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = mBottom.load(std::memory_order_acquire);
+        if (t < b) {
+            Ring *const ring = mRing.load(std::memory_order_acquire);
+            Item item = ring->at(t).load(std::memory_order_relaxed);
+            if (mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return item;
+            }
+        }
+        return nullptr;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t size() const
+    {
+        const int64_t b = mBottom.load(std::memory_order_relaxed);
+        const int64_t t = mTop.load(std::memory_order_relaxed);
+        return b > t ? size_t(b - t) : 0;
+    }
+
+private:
+    struct Ring
+    {
+        int64_t capacity;
+        std::unique_ptr<std::atomic<Item>[]> items;
+
+        std::atomic<Item> &at(int64_t index)
+        {
+            return items[index & (capacity - 1)];
+        }
+    };
+
+    static Ring *newRing(int64_t capacity)
+    {
+        return new Ring{capacity, std::unique_ptr<std::atomic<Item>[]>(new std::atomic<Item>[capacity])};
+    }
+
+    Ring *grow(Ring *ring, int64_t t, int64_t b)
+    {
+        Ring *const bigger = newRing(ring->capacity * 2);
+        for (int64_t i = t; i < b; i++) {
+            bigger->at(i).store(ring->at(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        mRetired.push_back(ring);
+        mRing.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> mTop{0};
+    alignas(64) std::atomic<int64_t> mBottom{0};
+    std::atomic<Ring *> mRing{nullptr};
+    std::vector<Ring *> mRetired;
+};
+
+struct TaskSystem::Worker
+{
+    /// Worker of the calling thread, if it is a WorkStealing worker
+    static thread_local Worker *current;
+
+    Worker(TaskSystem *system, uint32_t workerIndex)
+            : owner(system),
+              index(workerIndex),
+              random(workerIndex * 0x9E3779B9u + 1)
+    {
+    }
+
+    TaskSystem *owner;
+    uint32_t index;
+    uint32_t random;
+    TaskDeque deque;
+};
+
+thread_local TaskSystem::Worker *TaskSystem::Worker::current = nullptr;
+
+TaskSystem::TaskSystem(uint32_t threadCount, std::string name, Mode mode)
         : mThreadCount(threadCount),
-          mName(std::move(name))
+          mName(std::move(name)),
+          mMode(mode)
 {
     if (mThreadCount == 0 || mThreadCount > GThread::hardwareConcurrency()) {
         mThreadCount = GThread::hardwareConcurrency();
@@ -44,6 +262,10 @@ TaskSystem::TaskSystem(uint32_t threadCount, std::string name)
 TaskSystem::~TaskSystem()
 {
     stop();
+    // Continuations of the abandoned tasks may have queued more
+    while (waitingTaskCount() > 0) {
+        clearTask();
+    }
 }
 
 uint32_t TaskSystem::threadCount() const
@@ -51,6 +273,11 @@ uint32_t TaskSystem::threadCount() const
     return mThreadCount;
 }
 
+TaskSystem::Mode TaskSystem::mode() const
+{
+    return mMode;
+}
+
 void TaskSystem::start()
 {
     if (mIsRunning.load()) {
@@ -61,30 +288,27 @@ void TaskSystem::start()
 
     mThreads.resize(mThreadCount);
 
+    if (mMode == WorkStealing) {
+        mWorkers.resize(mThreadCount);
+        for (uint32_t i = 0; i < mThreadCount; i++) {
+            mWorkers[i].reset(new Worker(this, i));
+        }
+    }
+
     for (uint32_t i = 0; i < mThreadCount; i++) {
         std::stringstream tNameS;
         tNameS << mName << "_" << i;
 
-        mThreads[i] = std::make_unique<GThread>([this] {
-            TaskFuncRef taskFuncRef;
-            while (true) {
-                {
-                    GLocker<GMutex> locker(mLock);
-                    mTaskCond.wait(locker, [this] {
-                        return !mIsRunning.load() || !mTaskQueue.empty();
-                    });
-                    if (!mIsRunning.load() && mTaskQueue.empty()) {
-                        break;
-                    }
-                    taskFuncRef = mTaskQueue.front();
-                    mTaskQueue.pop_front();
-                }
-                if (taskFuncRef.active->load()) {
-                    GX_ASSERT(taskFuncRef.func);
-                    taskFuncRef.func();
-                }
-            }
-        }, tNameS.str());
+        if (mMode == WorkStealing) {
+            Worker *worker = mWorkers[i].get();
+            mThreads[i] = std::make_unique<GThread>([this, worker] {
+                workStealingLoop(worker);
+            }, tNameS.str());
+        } else {
+            mThreads[i] = std::make_unique<GThread>([this] {
+                sharedQueueLoop();
+            }, tNameS.str());
+        }
         mThreads[i]->setPriority(mPriority);
     }
 }
@@ -98,18 +322,21 @@ void TaskSystem::stopAndWait()
     {
         GLockerGuard locker(mLock);
         mIsRunning.store(false);
+        ++mWakeEpoch;
         mTaskCond.notify_all();
     }
     for (auto &thread: mThreads) {
         thread->join();
     }
+    mThreads.clear();
+
+    GLockerGuard locker(mLock);
+    mWorkers.clear();
 }
 
 void TaskSystem::stop()
 {
-    if (!mIsRunning.load()) {
-        return;
-    }
+    // Tasks queued before start() or after a previous stop() are abandoned too
     clearTask();
     stopAndWait();
 }
@@ -137,31 +364,530 @@ ThreadPriority TaskSystem::getThreadPriority() const
 uint64_t TaskSystem::waitingTaskCount() const
 {
     GLockerGuard locker(mLock);
-    return (uint64_t) mTaskQueue.size();
+    uint64_t count = (uint64_t) mTaskQueue.size() + (uint64_t) mInjectQueue.size();
+    for (auto &worker: mWorkers) {
+        count += worker->deque.size();
+    }
+    return count;
 }
 
-TaskSystem::TaskFuncRef TaskSystem::pushTask(const TaskSystem::TaskFunc &task)
+void TaskSystem::pushTask(TaskFunc task, TaskStatePtr state)
 {
+    if (mMode == WorkStealing) {
+        auto *taskRef = new TaskFuncRef{std::move(task), std::move(state)};
+        Worker *const worker = Worker::current;
+        if (worker && worker->owner == this) {
+            worker->deque.push(taskRef);
+            wakeWorker();
+        } else {
+            GLockerGuard locker(mLock);
+            mInjectQueue.push_back(taskRef);
+            mInjectCount.fetch_add(1, std::memory_order_relaxed);
+            mTaskCond.notify_one();
+        }
+        return;
+    }
     GLockerGuard locker(mLock);
-    TaskFuncRef taskRef{task, std::make_shared<std::atomic<bool>>(true)};
-    mTaskQueue.push_back(taskRef);
+    mTaskQueue.push_back(TaskFuncRef{std::move(task), std::move(state)});
     mTaskCond.notify_one();
-    return taskRef;
 }
 
-TaskSystem::TaskFuncRef TaskSystem::pushTaskFront(const TaskSystem::TaskFunc &task)
+void TaskSystem::pushTaskFront(TaskFunc task, TaskStatePtr state)
 {
     GLockerGuard locker(mLock);
-    TaskFuncRef taskRef{task, std::make_shared<std::atomic<bool>>(true)};
-    mTaskQueue.push_front(taskRef);
+    if (mMode == WorkStealing) {
+        // Workers look at the injection queue as soon as their own deque is empty
+        mInjectQueue.push_front(new TaskFuncRef{std::move(task), std::move(state)});
+        mInjectCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mTaskQueue.push_front(TaskFuncRef{std::move(task), std::move(state)});
+    }
     mTaskCond.notify_one();
-    return taskRef;
+}
+
+void TaskSystem::runTask(TaskFuncRef &taskRef)
+{
+    if (!taskRef.state || taskRef.state->isActive()) {
+        GX_ASSERT(taskRef.func);
+        taskRef.func();
+    } else {
+        taskRef.state->abandon();
+    }
 }
 
 void TaskSystem::clearTask()
 {
-    GLockerGuard locker(mLock);
-    mTaskQueue.clear();
+    std::vector<TaskStatePtr> dropped;
+    {
+        GLockerGuard locker(mLock);
+        for (auto &taskRef: mTaskQueue) {
+            dropped.push_back(std::move(taskRef.state));
+        }
+        mTaskQueue.clear();
+        for (TaskFuncRef *taskRef: mInjectQueue) {
+            dropped.push_back(std::move(taskRef->state));
+            delete taskRef;
+        }
+        mInjectQueue.clear();
+        mInjectCount.store(0, std::memory_order_relaxed);
+        for (auto &worker: mWorkers) {
+            while (!worker->deque.empty()) {
+                auto *taskRef = static_cast<TaskFuncRef *>(worker->deque.steal());
+                if (taskRef) {
+                    dropped.push_back(std::move(taskRef->state));
+                    delete taskRef;
+                }
+            }
+        }
+    }
+    // Outside the lock, continuations of the dropped tasks may submit again
+    for (auto &state: dropped) {
+        if (state) {
+            state->abandon();
+        }
+    }
+}
+
+void TaskSystem::sharedQueueLoop()
+{
+    TaskFuncRef taskFuncRef;
+    while (true) {
+        {
+            GLocker<GMutex> locker(mLock);
+            mTaskCond.wait(locker, [this] {
+                return !mIsRunning.load() || !mTaskQueue.empty();
+            });
+            if (!mIsRunning.load() && mTaskQueue.empty()) {
+                break;
+            }
+            taskFuncRef = std::move(mTaskQueue.front());
+            mTaskQueue.pop_front();
+        }
+        runTask(taskFuncRef);
+    }
+}
+
+void TaskSystem::workStealingLoop(Worker *worker)
+{
+    Worker::current = worker;
+    while (true) {
+        TaskFuncRef *taskRef = findTask(worker);
+        if (taskRef) {
+            std::unique_ptr<TaskFuncRef> holder(taskRef);
+            runTask(*taskRef);
+            continue;
+        }
+
+        GLocker<GMutex> locker(mLock);
+        if (!mIsRunning.load() && !hasQueuedTask()) {
+            break;
+        }
+        // Announce the sleep before the last check, a worker pushing to its deque then sees it (wakeWorker())
+        mSleepingCount.fetch_add(1, std::memory_order_seq_cst);
+        if (mIsRunning.load() && !hasQueuedTask()) {
+            const uint64_t epoch = mWakeEpoch;
+            mTaskCond.wait(locker, [this, epoch] {
+                return mWakeEpoch != epoch || !mInjectQueue.empty() || !mIsRunning.load();
+            });
+        }
+        mSleepingCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    Worker::current = nullptr;
+}
+
+TaskSystem::TaskFuncRef *TaskSystem::findTask(Worker *worker)
+{
+    auto *taskRef = static_cast<TaskFuncRef *>(worker->deque.take());
+    if (taskRef) {
+        return taskRef;
+    }
+    if (mInjectCount.load(std::memory_order_relaxed) > 0) {
+        GLockerGuard locker(mLock);
+        if (!mInjectQueue.empty()) {
+            taskRef = mInjectQueue.front();
+            mInjectQueue.pop_front();
+            mInjectCount.fetch_sub(1, std::memory_order_relaxed);
+            return taskRef;
+        }
+    }
+    return stealTask(worker);
+}
+
+TaskSystem::TaskFuncRef *TaskSystem::stealTask(Worker *worker)
+{
+    const auto count = (uint32_t) mWorkers.size();
+    if (count < 2) {
+        return nullptr;
+    }
+    // xorshift32, victims are visited from a random start
+    uint32_t r = worker->random;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    worker->random = r;
+
+    // A second round picks up items lost to a racing thief
+    for (uint32_t round = 0; round < 2; round++) {
+        for (uint32_t i = 0; i < count; i++) {
+            Worker *const victim = mWorkers[(r + i) % count].get();
+            if (victim == worker) {
+                continue;
+            }
+            auto *taskRef = static_cast<TaskFuncRef *>(victim->deque.steal());
+            if (taskRef) {
+                return taskRef;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool TaskSystem::hasQueuedTask() const
+{
+    if (!mInjectQueue.empty()) {
+        return true;
+    }
+    for (auto &worker: mWorkers) {
+        if (!worker->deque.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskSystem::wakeWorker()
+{
+    // Pairs with the increment of mSleepingCount in workStealingLoop()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleepingCount.load(std::memory_order_relaxed) > 0) {
+        GLockerGuard locker(mLock);
+        ++mWakeEpoch;
+        mTaskCond.notify_one();
+    }
+}
+
+/**
+ * Shared state of one parallelRange() call. Each participant owns a slot holding the rest of its share,
+ * it takes grain sized chunks from the front, and when its slot is empty it steals the back half
+ * of the largest remaining slot (all of it when at most grain is left).
+ * Helpers starting late find nothing and return, without touching the caller's context.
+ */
+class ParallelRange
+{
+public:
+    using RangeFunc = void (*)(void *, uint32_t, size_t, size_t);
+
+    ParallelRange(size_t count, size_t grain, uint32_t participants, RangeFunc func, void *context)
+            : mCount(count),
+              mGrain(grain),
+              mSlots(participants),
+              mFunc(func),
+              mContext(context)
+    {
+        for (uint32_t i = 0; i < participants; i++) {
+            mSlots[i].begin.store(count * i / participants, std::memory_order_relaxed);
+            mSlots[i].end.store(count * (i + 1) / participants, std::memory_order_relaxed);
+        }
+    }
+
+    void work(uint32_t participant)
+    {
+        size_t begin, end;
+        while (true) {
+            if (!takeChunk(participant, begin, end)) {
+                if (!stealHalf(participant)) {
+                    break;
+                }
+                continue;
+            }
+            if (!mFailed.load(std::memory_order_relaxed)) {
+                try {
+                    mFunc(mContext, participant, begin, end);
+                } catch (...) {
+                    GLockerGuard locker(mLock);
+                    if (!mError) {
+                        mError = std::current_exception();
+                    }
+                    mFailed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (mDone.fetch_add(end - begin, std::memory_order_acq_rel) + (end - begin) == mCount) {
+                GLockerGuard locker(mLock);
+                mDoneCond.notify_all();
+            }
+        }
+    }
+
+    /// Caller only, after its own work()
+    void waitAndRethrow()
+    {
+        GLocker<GMutex> locker(mLock);
+        mDoneCond.wait(locker, [this] {
+            return mDone.load(std::memory_order_acquire) == mCount;
+        });
+        if (mError) {
+            std::rethrow_exception(mError);
+        }
+    }
+
+private:
+    bool takeChunk(uint32_t participant, size_t &begin, size_t &end)
+    {
+        Slot &slot = mSlots[participant];
+        GLockerGuard locker(slot.lock);
+        begin = slot.begin.load(std::memory_order_relaxed);
+        end = slot.end.load(std::memory_order_relaxed);
+        if (begin >= end) {
+            return false;
+        }
+        end = std::min(end, begin + mGrain);
+        slot.begin.store(end, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool stealHalf(uint32_t participant)
+    {
+        while (true) {
+            // The sizes are only a hint, the victim is checked again under its lock
+            Slot *victim = nullptr;
+            size_t largest = 0;
+            for (auto &slot: mSlots) {
+                const size_t b = slot.begin.load(std::memory_order_relaxed);
+                const size_t e = slot.end.load(std::memory_order_relaxed);
+                if (e > b && e - b > largest) {
+                    largest = e - b;
+                    victim = &slot;
+                }
+            }
+            if (!victim) {
+                return false;
+            }
+
+            size_t begin, end;
+            {
+                GLockerGuard locker(victim->lock);
+                begin = victim->begin.load(std::memory_order_relaxed);
+                end = victim->end.load(std::memory_order_relaxed);
+                if (begin >= end) {
+                    continue;
+                }
+                if (end - begin > mGrain) {
+                    begin = end - (end - begin) / 2;
+                }
+                victim->end.store(begin, std::memory_order_relaxed);
+            }
+            Slot &own = mSlots[participant];
+            GLockerGuard locker(own.lock);
+            own.begin.store(begin, std::memory_order_relaxed);
+            own.end.store(end, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        GMutex lock;
+        std::atomic<size_t> begin{0};
+        std::atomic<size_t> end{0};
+    };
+
+    const size_t mCount;
+    const size_t mGrain;
+    std::vector<Slot> mSlots;
+    RangeFunc mFunc;
+    void *mContext;
+
+    std::atomic<size_t> mDone{0};
+    std::atomic<bool> mFailed{false};
+    GMutex mLock;
+    std::condition_variable mDoneCond;
+    std::exception_ptr mError;
+};
+
+size_t TaskSystem::resolveGrain(size_t count, size_t grain) const
+{
+    if (grain > 0) {
+        return grain;
+    }
+    // About 8 chunks per thread, enough for the stealing to even out the load
+    return std::max<size_t>(1, count / (size_t(mThreadCount + 1) * 8));
+}
+
+uint32_t TaskSystem::participantCount(size_t count, size_t grain) const
+{
+    if (!mIsRunning.load()) {
+        return 1;
+    }
+    const size_t chunks = (count + grain - 1) / grain;
+    return (uint32_t) std::min<size_t>(chunks, size_t(mThreadCount) + 1);
+}
+
+void TaskSystem::parallelRange(size_t count, size_t grain, uint32_t participants, RangeFunc func, void *context)
+{
+    if (participants <= 1) {
+        func(context, 0, 0, count);
+        return;
+    }
+    auto range = std::make_shared<ParallelRange>(count, grain, participants, func, context);
+    for (uint32_t i = 1; i < participants; i++) {
+        pushTask([range, i] {
+            range->work(i);
+        }, nullptr);
+    }
+    range->work(0);
+    range->waitAndRethrow();
+}
+
+/**
+ * State of one run of a TaskGraph. Counts the node tasks in flight (plus one while the roots are submitted),
+ * the run completes when the count drops to zero, so no thread touches the graph afterwards.
+ * It is also the cancellation state of the node tasks: cancelling the run skips the queued nodes.
+ */
+class TaskGraph::Run : public details::TaskState<bool>
+{
+public:
+    Run(const TaskGraph &graph, TaskSystem &system)
+            : mGraph(graph),
+              mSystem(system),
+              mPending(new std::atomic<uint32_t>[graph.mNodes.size()])
+    {
+        for (size_t i = 0; i < graph.mNodes.size(); i++) {
+            mPending[i].store(graph.mNodes[i].predecessorCount, std::memory_order_relaxed);
+        }
+    }
+
+    void start(const std::shared_ptr<Run> &self)
+    {
+        for (NodeId id = 0; id < (NodeId) mGraph.mNodes.size(); id++) {
+            if (mGraph.mNodes[id].predecessorCount == 0) {
+                submitNode(self, id);
+            }
+        }
+        release();
+    }
+
+    void abandon() override
+    {
+        fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        release();
+    }
+
+private:
+    void submitNode(const std::shared_ptr<Run> &self, NodeId id)
+    {
+        mInFlight.fetch_add(1, std::memory_order_relaxed);
+        mSystem.pushTask([self, id] {
+            self->runNode(self, id);
+        }, self);
+    }
+
+    void runNode(const std::shared_ptr<Run> &self, NodeId id)
+    {
+        const Node &node = mGraph.mNodes[id];
+        if (!mFailed.load(std::memory_order_acquire)) {
+            try {
+                node.func();
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+        if (!mFailed.load(std::memory_order_acquire)) {
+            for (NodeId successor: node.successors) {
+                if (mPending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    submitNode(self, successor);
+                }
+            }
+        }
+        release();
+    }
+
+    void fail(std::exception_ptr error)
+    {
+        GLockerGuard locker(mErrorLock);
+        if (!mFailed.load(std::memory_order_relaxed)) {
+            mFirstError = std::move(error);
+            mFailed.store(true, std::memory_order_release);
+        }
+    }
+
+    void release()
+    {
+        if (mInFlight.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if (mFailed.load(std::memory_order_acquire)) {
+            GLockerGuard locker(mErrorLock);
+            mError = mFirstError;
+        } else {
+            mValue.emplace(true);
+        }
+        complete();
+    }
+
+private:
+    const TaskGraph &mGraph;
+    TaskSystem &mSystem;
+    std::unique_ptr<std::atomic<uint32_t>[]> mPending;
+    std::atomic<size_t> mInFlight{1};
+
+    std::atomic<bool> mFailed{false};
+    GMutex mErrorLock;
+    std::exception_ptr mFirstError;
+};
+
+TaskGraph::NodeId TaskGraph::add(std::function<void()> func)
+{
+    mNodes.push_back(Node{std::move(func)});
+    return (NodeId) mNodes.size() - 1;
+}
+
+void TaskGraph::precede(NodeId before, NodeId after)
+{
+    GX_ASSERT(before < mNodes.size() && after < mNodes.size());
+    mNodes[before].successors.push_back(after);
+    mNodes[after].predecessorCount++;
+}
+
+size_t TaskGraph::size() const
+{
+    return mNodes.size();
+}
+
+TaskSystem::Task<bool> TaskGraph::run(TaskSystem &system)
+{
+    auto run = std::make_shared<Run>(*this, system);
+    if (hasCycle()) {
+        run->setError(std::make_exception_ptr(std::logic_error("TaskGraph has a cycle")));
+    } else {
+        run->start(run);
+    }
+    return {std::move(run), &system};
+}
+
+bool TaskGraph::hasCycle() const
+{
+    // Kahn's algorithm, a cycle leaves nodes that never become ready
+    std::vector<uint32_t> pending(mNodes.size());
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < (NodeId) mNodes.size(); id++) {
+        pending[id] = mNodes[id].predecessorCount;
+        if (pending[id] == 0) {
+            ready.push_back(id);
+        }
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+        const NodeId id = ready.back();
+        ready.pop_back();
+        visited++;
+        for (NodeId successor: mNodes[id].successors) {
+            if (--pending[successor] == 0) {
+                ready.push_back(successor);
+            }
+        }
+    }
+    return visited != mNodes.size();
 }
 
 GX_NS_END
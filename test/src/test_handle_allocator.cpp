@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/gid_allocator.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+
+using namespace gx;
+
+TEST(HandleAllocator, AllocFree)
+{
+    GHandleAllocator allocator;
+    const GHandle handle = allocator.alloc();
+    ASSERT_FALSE(handle.isNull());
+    EXPECT_TRUE(allocator.isValid(handle));
+    EXPECT_EQ(allocator.size(), 1u);
+
+    EXPECT_TRUE(allocator.free(handle));
+    EXPECT_FALSE(allocator.isValid(handle));
+    EXPECT_FALSE(allocator.free(handle));
+    EXPECT_EQ(allocator.size(), 0u);
+
+    // The slot is reused with a new generation, the old handle stays stale
+    const GHandle reused = allocator.alloc();
+    EXPECT_EQ(reused.index, handle.index);
+    EXPECT_NE(reused.generation, handle.generation);
+    EXPECT_TRUE(allocator.isValid(reused));
+    EXPECT_FALSE(allocator.isValid(handle));
+    EXPECT_EQ(GHandle::fromValue(reused.value()), reused);
+}
+
+TEST(HandleAllocator, InvalidHandles)
+{
+    GHandleAllocator allocator;
+    const GHandle handle = allocator.alloc();
+    EXPECT_FALSE(allocator.isValid(GHandle{}));
+    EXPECT_FALSE(allocator.free(GHandle{}));
+    EXPECT_FALSE(allocator.isValid(GHandle{handle.index, handle.generation + 1}));
+    EXPECT_FALSE(allocator.isValid(GHandle{handle.index + 1, 1}));
+    // Indices past the last segment must not be looked up
+    EXPECT_FALSE(allocator.isValid(GHandle{GHandle::NULL_INDEX - 1, 1}));
+    EXPECT_FALSE(allocator.free(GHandle{GHandle::NULL_INDEX - 1, 1}));
+}
+
+TEST(HandleAllocator, GrowAndReset)
+{
+    GHandleAllocator allocator;
+    std::vector<GHandle> handles;
+    for (int i = 0; i < 10000; i++) {
+        handles.push_back(allocator.alloc());
+    }
+    std::set<uint32_t> indices;
+    for (const GHandle &handle: handles) {
+        EXPECT_TRUE(allocator.isValid(handle));
+        indices.insert(handle.index);
+    }
+    EXPECT_EQ(indices.size(), handles.size());
+    EXPECT_EQ(allocator.size(), 10000u);
+    EXPECT_GE(allocator.capacity(), 10000u);
+
+    allocator.reset();
+    EXPECT_EQ(allocator.size(), 0u);
+    for (const GHandle &handle: handles) {
+        EXPECT_FALSE(allocator.isValid(handle));
+    }
+    EXPECT_EQ(allocator.alloc().index, 0u);
+    EXPECT_EQ(allocator.capacity(), 10000u);
+}
+
+TEST(HandleAllocator, Concurrent)
+{
+    GHandleAllocator allocator;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&allocator, &failures] {
+            std::vector<GHandle> handles;
+            for (int round = 0; round < 100; round++) {
+                for (int i = 0; i < 200; i++) {
+                    const GHandle handle = allocator.alloc();
+                    failures += !allocator.isValid(handle);
+                    handles.push_back(handle);
+                }
+                for (const GHandle &handle: handles) {
+                    failures += !allocator.free(handle);
+                    failures += allocator.isValid(handle);
+                }
+                handles.clear();
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(allocator.size(), 0u);
+    EXPECT_LE(allocator.capacity(), 4u * 200u);
+}
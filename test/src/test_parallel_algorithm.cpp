@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/parallel_algorithm.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+/// Around the insertion sorted run and the 8K grain of the parallel passes
+const std::vector<size_t> SIZES = {0, 1, 2, 31, 32, 33, 63, 64, 65, 1000,
+                                   8191, 8192, 8193, 16383, 16384, 16385, 50000};
+
+struct Item
+{
+    int key;
+    std::string payload;
+};
+
+bool byKey(const Item &a, const Item &b)
+{
+    return a.key < b.key;
+}
+
+bool operator==(const Item &a, const Item &b)
+{
+    return a.key == b.key && a.payload == b.payload;
+}
+
+/// Few distinct keys, so that stability is visible in the payloads
+std::vector<Item> randomItems(size_t n, std::mt19937 &random)
+{
+    std::vector<Item> items(n);
+    for (size_t i = 0; i < n; i++) {
+        items[i] = Item{int(random() % 100), std::to_string(i)};
+    }
+    return items;
+}
+
+/// Scratch that cannot provide memory, the algorithms fall back to their serial path
+struct FailingScratch
+{
+    void *alloc(size_t, size_t)
+    {
+        return nullptr;
+    }
+
+    void free(void *, size_t)
+    {
+    }
+};
+
+class ParallelAlgorithm : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mSystem.start();
+    }
+
+protected:
+    TaskSystem mSystem{4, "TestParallelAlgorithm", TaskSystem::WorkStealing};
+    HeapPond mScratch{"TestParallelScratch"};
+    std::mt19937 mRandom{1};
+};
+
+}
+
+TEST_F(ParallelAlgorithm, SortTrivial)
+{
+    for (size_t n: SIZES) {
+        std::vector<int> values(n);
+        for (int &v: values) {
+            v = int(mRandom() % 1000);
+        }
+        std::vector<int> expected = values;
+        std::stable_sort(expected.begin(), expected.end());
+        parallelSort(mSystem, mScratch, values.begin(), values.end());
+        EXPECT_EQ(values, expected) << "n = " << n;
+    }
+    EXPECT_EQ(mScratch.size(), 0u);
+}
+
+TEST_F(ParallelAlgorithm, SortIsStable)
+{
+    for (size_t n: SIZES) {
+        std::vector<Item> items = randomItems(n, mRandom);
+        std::vector<Item> expected = items;
+        std::stable_sort(expected.begin(), expected.end(), byKey);
+        parallelSort(mSystem, mScratch, items.begin(), items.end(), byKey);
+        EXPECT_TRUE(items == expected) << "n = " << n;
+    }
+    EXPECT_EQ(mScratch.size(), 0u);
+}
+
+TEST_F(ParallelAlgorithm, SortWithoutScratch)
+{
+    FailingScratch scratch;
+    std::vector<Item> items = randomItems(20000, mRandom);
+    std::vector<Item> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), byKey);
+    parallelSort(mSystem, scratch, items.begin(), items.end(), byKey);
+    EXPECT_TRUE(items == expected);
+}
+
+TEST_F(ParallelAlgorithm, Merge)
+{
+    for (size_t na: SIZES) {
+        const size_t nb = na / 2 + 7;
+        std::vector<Item> a = randomItems(na, mRandom);
+        std::vector<Item> b = randomItems(nb, mRandom);
+        std::stable_sort(a.begin(), a.end(), byKey);
+        std::stable_sort(b.begin(), b.end(), byKey);
+
+        std::vector<Item> expected(na + nb);
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin(), byKey);
+        std::vector<Item> merged(na + nb);
+        auto end = parallelMerge(mSystem, a.begin(), a.end(), b.begin(), b.end(), merged.begin(), byKey);
+        EXPECT_TRUE(end == merged.end());
+        EXPECT_TRUE(merged == expected) << "na = " << na;
+    }
+}
+
+TEST_F(ParallelAlgorithm, InclusiveScan)
+{
+    for (size_t n: SIZES) {
+        std::vector<int64_t> values(n);
+        for (int64_t &v: values) {
+            v = int64_t(mRandom() % 100);
+        }
+        std::vector<int64_t> expected(n);
+        std::inclusive_scan(values.begin(), values.end(), expected.begin());
+        std::vector<int64_t> result(n);
+        auto end = parallelInclusiveScan(mSystem, mScratch, values.begin(), values.end(), result.begin());
+        EXPECT_TRUE(end == result.end());
+        EXPECT_EQ(result, expected) << "n = " << n;
+
+        // In place
+        parallelInclusiveScan(mSystem, mScratch, values.begin(), values.end(), values.begin());
+        EXPECT_EQ(values, expected) << "n = " << n;
+    }
+    EXPECT_EQ(mScratch.size(), 0u);
+}
+
+TEST_F(ParallelAlgorithm, ExclusiveScan)
+{
+    for (size_t n: SIZES) {
+        std::vector<int64_t> values(n);
+        for (int64_t &v: values) {
+            v = int64_t(mRandom() % 100);
+        }
+        std::vector<int64_t> expected(n);
+        std::exclusive_scan(values.begin(), values.end(), expected.begin(), int64_t(5));
+        std::vector<int64_t> result(n);
+        auto end = parallelExclusiveScan(mSystem, mScratch, values.begin(), values.end(), result.begin(), int64_t(5));
+        EXPECT_TRUE(end == result.end());
+        EXPECT_EQ(result, expected) << "n = " << n;
+
+        parallelExclusiveScan(mSystem, mScratch, values.begin(), values.end(), values.begin(), int64_t(5));
+        EXPECT_EQ(values, expected) << "n = " << n;
+    }
+    EXPECT_EQ(mScratch.size(), 0u);
+}
+
+TEST_F(ParallelAlgorithm, ScanNonTrivial)
+{
+    // Concatenation is associative but not commutative, so the block order must be kept
+    const auto concat = [](const std::string &a, const std::string &b) {
+        return a + b;
+    };
+    for (size_t n: {size_t(33), size_t(8193)}) {
+        std::vector<std::string> values(n);
+        for (std::string &v: values) {
+            v = std::string(1, char('a' + mRandom() % 26));
+        }
+        std::vector<std::string> expected(n);
+        std::inclusive_scan(values.begin(), values.end(), expected.begin(), concat);
+        std::vector<std::string> result(n);
+        parallelInclusiveScan(mSystem, mScratch, values.begin(), values.end(), result.begin(), concat);
+        EXPECT_TRUE(result == expected) << "n = " << n;
+
+        std::exclusive_scan(values.begin(), values.end(), expected.begin(), std::string(">"), concat);
+        parallelExclusiveScan(mSystem, mScratch, values.begin(), values.end(), values.begin(), std::string(">"),
+                              concat);
+        EXPECT_TRUE(values == expected) << "n = " << n;
+    }
+    EXPECT_EQ(mScratch.size(), 0u);
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/allocator.h>
+
+#include <memory>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+struct Obj
+{
+    explicit Obj(int v) : value(v)
+    {
+        memset(data, v, sizeof(data));
+    }
+
+    ~Obj()
+    {
+        destroyed++;
+    }
+
+    char data[32];
+    int value;
+
+    static int destroyed;
+};
+
+int Obj::destroyed = 0;
+
+}
+
+TEST(PondSmartPtr, SharedPtrPool)
+{
+    using SharedPond = Pond<SharedPtrPoolAllocator<Obj>, LockingPolicy::NoLock>;
+    SharedPond pond("TestSharedPtrPool");
+    ASSERT_GE(pond.getAllocator().elementSize(), details::sharedPtrBlockSize<Obj>());
+
+    std::vector<std::shared_ptr<Obj>> objects;
+    for (int i = 0; i < 100; i++) {
+        objects.push_back(pond.makeShared<Obj>(i));
+        ASSERT_NE(objects.back(), nullptr);
+    }
+    // One element per object, its control block included
+    EXPECT_EQ(pond.size(), 100 * pond.getAllocator().elementSize());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(objects[i]->value, i);
+        EXPECT_EQ(objects[i]->data[31], char(i));
+    }
+    Obj::destroyed = 0;
+    objects.clear();
+    EXPECT_EQ(Obj::destroyed, 100);
+    EXPECT_EQ(pond.size(), 0u);
+}
+
+TEST(PondSmartPtr, ControlBlockInElement)
+{
+    Pond<SharedPtrPoolAllocator<Obj>, LockingPolicy::NoLock> pond("TestControlBlockPool");
+    auto object = pond.makeShared<Obj>(1);
+    std::weak_ptr<Obj> weak = object;
+
+    // The element holds the control block, so it lives as long as the weak reference
+    object.reset();
+    EXPECT_TRUE(weak.expired());
+    EXPECT_EQ(pond.size(), pond.getAllocator().elementSize());
+    weak.reset();
+    EXPECT_EQ(pond.size(), 0u);
+}
+
+TEST(PondSmartPtr, FallbackForSmallElements)
+{
+    // The element only fits the object, its control block comes from the heap
+    Pond<ObjectPoolAllocator<Obj>, LockingPolicy::NoLock> pond("TestObjectPool");
+    auto object = pond.makeShared<Obj>(2);
+    ASSERT_NE(object, nullptr);
+    EXPECT_EQ(object->value, 2);
+    std::weak_ptr<Obj> weak = object;
+
+    object.reset();
+    EXPECT_TRUE(weak.expired());
+    EXPECT_EQ(pond.size(), 0u);
+
+    Pond<DynamicPoolAllocator, LockingPolicy::NoLock> dynamic("TestDynamicPool", size_t(0), sizeof(Obj), alignof(Obj));
+    auto dynamicObject = dynamic.makeShared<Obj>(3);
+    ASSERT_NE(dynamicObject, nullptr);
+    EXPECT_EQ(dynamicObject->value, 3);
+    EXPECT_EQ(dynamic.size(), dynamic.getAllocator().elementSize());
+}
+
+TEST(PondSmartPtr, ExhaustedPond)
+{
+    Pond<LinearAllocator, LockingPolicy::NoLock> pond("TestLinearPond", sizeof(Obj));
+    auto first = pond.makeShared<Obj>(1);
+    auto second = pond.makeShared<Obj>(2);
+    EXPECT_EQ(second, nullptr);
+}
+
+TEST(PondSmartPtr, Aligned)
+{
+    struct alignas(64) Aligned
+    {
+        int value = 0;
+    };
+    HeapPond pond("TestAlignedPond");
+    auto object = pond.makeShared<Aligned, 128>();
+    ASSERT_NE(object, nullptr);
+    EXPECT_EQ(uintptr_t(object.get()) % alignof(Aligned), 0u);
+}
+
+TEST(PondSmartPtr, Unique)
+{
+    using ObjPond = Pond<ObjectPoolAllocator<Obj>, LockingPolicy::NoLock>;
+    ObjPond pond("TestUniquePool");
+    static_assert(sizeof(PondUniquePtr<Obj, ObjPond>) == 2 * sizeof(void *));
+
+    Obj::destroyed = 0;
+    {
+        auto object = pond.makeUnique<Obj>(4);
+        ASSERT_NE(object, nullptr);
+        EXPECT_EQ(object->value, 4);
+        EXPECT_EQ(pond.size(), sizeof(Obj));
+
+        UniquePtr<Obj> converted = pond.makeUnique<Obj>(5);
+        EXPECT_EQ(converted->value, 5);
+    }
+    EXPECT_EQ(Obj::destroyed, 2);
+    EXPECT_EQ(pond.size(), 0u);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/allocator.h>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+constexpr size_t ELEMENT_SIZE = 32;
+
+template<typename POND>
+void checkBatch(POND &pond, size_t count)
+{
+    std::vector<void *> elements(count);
+    ASSERT_EQ(pond.allocBatch(elements.data(), count), count);
+    EXPECT_EQ(std::set<void *>(elements.begin(), elements.end()).size(), count);
+    for (size_t i = 0; i < count; i++) {
+        memset(elements[i], int(i), ELEMENT_SIZE);
+    }
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(static_cast<uint8_t *>(elements[i])[ELEMENT_SIZE - 1], uint8_t(i));
+    }
+    EXPECT_EQ(pond.size(), count * ELEMENT_SIZE);
+
+    // Free in two halves, then take them back before any new element is carved
+    pond.freeBatch(elements.data(), count / 2);
+    pond.freeBatch(elements.data() + count / 2, count - count / 2);
+    EXPECT_EQ(pond.size(), 0u);
+    const size_t capacity = pond.capacity();
+    ASSERT_EQ(pond.allocBatch(elements.data(), count), count);
+    EXPECT_EQ(pond.capacity(), capacity);
+    pond.freeBatch(elements.data(), count);
+    EXPECT_EQ(pond.size(), 0u);
+}
+
+}
+
+TEST(PoolBatch, PoolAllocator)
+{
+    // The batch outgrows the area and continues on heap slabs
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::Mutex> pond("TestBatchPool", ELEMENT_SIZE * 1000);
+    checkBatch(pond, 5000);
+}
+
+TEST(PoolBatch, DynamicPoolAllocator)
+{
+    Pond<DynamicPoolAllocator, LockingPolicy::SpinLock> pond("TestBatchDynamicPool", ELEMENT_SIZE * 100, ELEMENT_SIZE,
+                                                             size_t(16));
+    checkBatch(pond, 1000);
+}
+
+TEST(PoolBatch, AtomicPoolAllocator)
+{
+    Pond<AtomicPoolAllocator<ELEMENT_SIZE>, LockingPolicy::NoLock> pond("TestBatchAtomicPool", ELEMENT_SIZE * 100);
+    checkBatch(pond, 1000);
+}
+
+TEST(PoolBatch, MixedWithSingle)
+{
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::NoLock> pond("TestBatchMixedPool", ELEMENT_SIZE * 16);
+    std::vector<void *> elements(8);
+    ASSERT_EQ(pond.allocBatch(elements.data(), elements.size()), elements.size());
+    void *single = pond.alloc(ELEMENT_SIZE);
+    EXPECT_EQ(std::count(elements.begin(), elements.end(), single), 0);
+    pond.free(single);
+    pond.freeBatch(elements.data(), elements.size());
+    pond.freeBatch(elements.data(), 0);
+    EXPECT_EQ(pond.size(), 0u);
+}
+
+TEST(PoolBatch, Tracking)
+{
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::Mutex, HeapArea, TrackingPolicy::Stats> pond("TestBatchTrackedPool",
+                                                                                                 ELEMENT_SIZE * 100);
+    std::vector<void *> elements(300);
+    ASSERT_EQ(pond.allocBatch(elements.data(), elements.size()), elements.size());
+    PondStats stats = pond.getTracking().snapshot();
+    EXPECT_EQ(stats.allocCount, 300u);
+    EXPECT_EQ(stats.currentBytes, 300u * ELEMENT_SIZE);
+
+    pond.freeBatch(elements.data(), elements.size());
+    stats = pond.getTracking().snapshot();
+    EXPECT_EQ(stats.outstanding(), 0u);
+    EXPECT_EQ(stats.currentBytes, 0u);
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/allocator.h>
+
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+constexpr size_t ELEMENT_SIZE = 64;
+constexpr size_t AREA_SIZE = 4 * 1024;
+/// More than the area holds, so that heap slabs are used too
+constexpr size_t ELEMENT_COUNT = 1000;
+
+/**
+ * Allocate count elements, none may be handed out twice, then free them all.
+ */
+template<typename POND>
+void exhaustAndRefill(POND &pond, size_t count)
+{
+    std::vector<void *> elements;
+    for (size_t i = 0; i < count; i++) {
+        void *p = pond.alloc(ELEMENT_SIZE);
+        ASSERT_NE(p, nullptr);
+        memset(p, int(i), ELEMENT_SIZE);
+        elements.push_back(p);
+    }
+    EXPECT_EQ(std::set<void *>(elements.begin(), elements.end()).size(), count);
+    EXPECT_EQ(pond.getAllocator().size(), count * ELEMENT_SIZE);
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(static_cast<uint8_t *>(elements[i])[ELEMENT_SIZE - 1], uint8_t(i));
+    }
+    for (void *p: elements) {
+        pond.free(p);
+    }
+    EXPECT_EQ(pond.getAllocator().size(), 0u);
+}
+
+/**
+ * Threads allocate and free concurrently, every element must be owned by one thread at a time.
+ */
+template<typename POND>
+void concurrentAllocFree(POND &pond)
+{
+    constexpr uint32_t THREAD_COUNT = 4;
+    constexpr size_t BATCH = 64;
+    constexpr size_t ROUNDS = 200;
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(THREAD_COUNT, 0);
+    for (uint32_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&pond, &failures, t] {
+            void *elements[BATCH];
+            for (size_t r = 0; r < ROUNDS; r++) {
+                for (auto &p: elements) {
+                    p = pond.alloc(ELEMENT_SIZE);
+                    memset(p, int(t), ELEMENT_SIZE);
+                }
+                for (auto &p: elements) {
+                    failures[t] += static_cast<uint8_t *>(p)[ELEMENT_SIZE - 1] != uint8_t(t);
+                    pond.free(p);
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (int failure: failures) {
+        EXPECT_EQ(failure, 0);
+    }
+    EXPECT_EQ(pond.getAllocator().size(), 0u);
+}
+
+}
+
+TEST(PoolLocking, MutexPool)
+{
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::Mutex> pond("TestMutexPool", AREA_SIZE);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    concurrentAllocFree(pond);
+}
+
+TEST(PoolLocking, SpinLockPool)
+{
+    Pond<PoolAllocator<ELEMENT_SIZE>, LockingPolicy::SpinLock> pond("TestSpinLockPool", AREA_SIZE);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    concurrentAllocFree(pond);
+}
+
+TEST(PoolLocking, LockFreePool)
+{
+    Pond<AtomicPoolAllocator<ELEMENT_SIZE>, LockingPolicy::NoLock> pond("TestLockFreePool");
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    concurrentAllocFree(pond);
+}
+
+TEST(PoolLocking, LockFreePoolWithArea)
+{
+    Pond<AtomicPoolAllocator<ELEMENT_SIZE>, LockingPolicy::NoLock> pond("TestLockFreeAreaPool", AREA_SIZE);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    exhaustAndRefill(pond, ELEMENT_COUNT);
+    concurrentAllocFree(pond);
+}
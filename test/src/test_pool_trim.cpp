@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/allocator.h>
+#include <gx/gglobal_memory_pool.h>
+
+#include <cstring>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+constexpr size_t LARGE_SIZE = 64 * 1024;
+constexpr size_t SMALL_SIZE = 1024;
+constexpr size_t COUNT = 8;
+
+std::vector<void *> fill(DynamicPoolAllocator &allocator, size_t elementSize, size_t count)
+{
+    std::vector<void *> elements;
+    for (size_t i = 0; i < count; i++) {
+        void *p = allocator.alloc(elementSize, 16);
+        memset(p, 1, elementSize);
+        elements.push_back(p);
+    }
+    return elements;
+}
+
+}
+
+TEST(PoolTrim, PurgeReturnsDecommittedPages)
+{
+    DynamicPoolAllocator allocator(LARGE_SIZE, 16);
+    for (void *p: fill(allocator, LARGE_SIZE, COUNT)) {
+        allocator.free(p);
+    }
+    const size_t freeSize = allocator.freeSize();
+    const size_t released = allocator.purge(SIZE_MAX, false);
+
+    // Only the whole pages after the link of each element are decommitted
+    const size_t pageSize = systemPageSize();
+    EXPECT_EQ(released % pageSize, 0u);
+    EXPECT_GE(released, COUNT * (LARGE_SIZE - 2 * pageSize));
+    EXPECT_LT(released, freeSize);
+    EXPECT_EQ(allocator.freeSize(), 0u);
+
+    // Purged elements are reused before new ones are carved
+    const size_t capacity = allocator.capacity();
+    const std::vector<void *> elements = fill(allocator, LARGE_SIZE, COUNT);
+    EXPECT_EQ(allocator.capacity(), capacity);
+    for (void *p: elements) {
+        allocator.free(p);
+    }
+}
+
+TEST(PoolTrim, PurgeStaysWithinBudget)
+{
+    DynamicPoolAllocator allocator(LARGE_SIZE, 16);
+    for (void *p: fill(allocator, LARGE_SIZE, COUNT)) {
+        allocator.free(p);
+    }
+    const size_t released = allocator.purge(3 * LARGE_SIZE, false);
+    EXPECT_GT(released, 0u);
+    EXPECT_LE(released, 3 * LARGE_SIZE);
+    EXPECT_EQ(allocator.freeSize(), (COUNT - 3) * LARGE_SIZE);
+}
+
+TEST(PoolTrim, PurgeSkipsSmallElements)
+{
+    DynamicPoolAllocator allocator(SMALL_SIZE, 16);
+    for (void *p: fill(allocator, SMALL_SIZE, COUNT)) {
+        allocator.free(p);
+    }
+    EXPECT_EQ(allocator.purge(SIZE_MAX, false), 0u);
+    EXPECT_EQ(allocator.freeSize(), COUNT * SMALL_SIZE);
+}
+
+TEST(PoolTrim, PurgeIdleOnly)
+{
+    DynamicPoolAllocator allocator(LARGE_SIZE, 16);
+    for (void *p: fill(allocator, LARGE_SIZE, COUNT)) {
+        allocator.free(p);
+    }
+    // Starts the idle window, nothing stayed free for a whole window yet
+    allocator.purge(SIZE_MAX, true);
+    void *p = allocator.alloc(LARGE_SIZE, 16);
+    allocator.free(p);
+
+    // The element taken and returned is not idle
+    EXPECT_EQ(allocator.idleSize(), (COUNT - 1) * LARGE_SIZE);
+    EXPECT_GT(allocator.purge(SIZE_MAX, true), 0u);
+    EXPECT_EQ(allocator.freeSize(), LARGE_SIZE);
+}
+
+TEST(PoolTrim, GlobalTrim)
+{
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 64; i++) {
+        uint32_t size = LARGE_SIZE;
+        blocks.push_back(GGlobalMemoryPool::alloc(size));
+    }
+    for (void *p: blocks) {
+        GGlobalMemoryPool::free(p, LARGE_SIZE);
+    }
+
+    GGlobalMemoryPool::setTrimPolicy(1000, 0, UINT64_MAX);
+    uint64_t released = 0;
+    for (int i = 0; i < 3; i++) {
+        released += GGlobalMemoryPool::trim();
+    }
+    EXPECT_GT(released, 0u);
+    EXPECT_EQ(released % systemPageSize(), 0u);
+    EXPECT_LE(released, 64 * LARGE_SIZE);
+}
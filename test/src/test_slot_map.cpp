@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/slot_map.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+using namespace gx;
+
+TEST(SlotMap, InsertErase)
+{
+    SlotMap<std::string> map;
+    const GHandle a = map.insert("a");
+    const GHandle b = map.insert("b");
+    EXPECT_EQ(map.size(), 2u);
+    ASSERT_NE(map.get(a), nullptr);
+    EXPECT_EQ(*map.get(a), "a");
+
+    EXPECT_TRUE(map.erase(a));
+    EXPECT_FALSE(map.erase(a));
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_EQ(map.get(a), nullptr);
+    EXPECT_EQ(*map.get(b), "b");
+
+    // The freed slot is reused with a new generation
+    const GHandle c = map.insert("c");
+    EXPECT_EQ(c.index, a.index);
+    EXPECT_NE(c.generation, a.generation);
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_EQ(*map.get(c), "c");
+    EXPECT_FALSE(map.contains(GHandle{}));
+}
+
+TEST(SlotMap, DenseStorage)
+{
+    SlotMap<int> map;
+    std::vector<GHandle> handles;
+    for (int i = 0; i < 8; i++) {
+        handles.push_back(map.insert(i));
+    }
+    map.erase(handles[2]);
+    map.erase(handles[5]);
+
+    // Values stay contiguous and every dense position maps back to its handle
+    ASSERT_EQ(map.size(), 6u);
+    for (size_t i = 0; i < map.size(); i++) {
+        const GHandle handle = map.handleAt(i);
+        ASSERT_NE(map.get(handle), nullptr);
+        EXPECT_EQ(map.get(handle), map.data() + i);
+    }
+    int sum = 0;
+    for (int value: map) {
+        sum += value;
+    }
+    EXPECT_EQ(sum, 0 + 1 + 3 + 4 + 6 + 7);
+}
+
+TEST(SlotMap, MoveOnlyValues)
+{
+    SlotMap<std::unique_ptr<int>> map;
+    const GHandle a = map.insert(std::make_unique<int>(1));
+    const GHandle b = map.insert(std::make_unique<int>(2));
+    EXPECT_TRUE(map.erase(a));
+    EXPECT_EQ(**map.get(b), 2);
+}
+
+TEST(SlotMap, Clear)
+{
+    SlotMap<std::string> map;
+    const GHandle a = map.insert("a");
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(a));
+    const GHandle b = map.insert("b");
+    EXPECT_NE(b, a);
+    EXPECT_FALSE(map.contains(a));
+}
+
+TEST(SlotMap, RandomAgainstUnorderedMap)
+{
+    SlotMap<std::string> map;
+    std::unordered_map<uint64_t, std::string> reference;
+    std::vector<GHandle> live;
+    std::vector<GHandle> erased;
+    std::mt19937 random(3);
+
+    for (int step = 0; step < 200000; step++) {
+        if (live.empty() || random() % 3) {
+            std::string value = std::to_string(step);
+            const GHandle handle = map.insert(value);
+            live.push_back(handle);
+            reference[handle.value()] = std::move(value);
+        } else {
+            const size_t i = random() % live.size();
+            const GHandle handle = live[i];
+            live[i] = live.back();
+            live.pop_back();
+            ASSERT_TRUE(map.erase(handle));
+            reference.erase(handle.value());
+            erased.push_back(handle);
+        }
+    }
+
+    ASSERT_EQ(map.size(), reference.size());
+    for (const GHandle &handle: live) {
+        const std::string *value = map.get(handle);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, reference[handle.value()]);
+    }
+    for (const GHandle &handle: erased) {
+        EXPECT_FALSE(map.contains(handle));
+    }
+    size_t count = 0;
+    map.forEach([&](GHandle handle, std::string &value) {
+        EXPECT_EQ(value, reference[handle.value()]);
+        count++;
+    });
+    EXPECT_EQ(count, reference.size());
+}
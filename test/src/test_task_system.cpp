@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026 Gxin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gx/task_system.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace gx;
+
+namespace
+{
+
+class TaskSystemTest : public ::testing::TestWithParam<TaskSystem::Mode>
+{
+protected:
+    void SetUp() override
+    {
+        mSystem = std::make_unique<TaskSystem>(4, "TestTaskSystem", GetParam());
+        mSystem->start();
+    }
+
+    void TearDown() override
+    {
+        mSystem.reset();
+    }
+
+    /**
+     * Occupy every worker until the returned flag is set, so that later tasks stay queued.
+     */
+    std::shared_ptr<std::atomic<bool>> block(std::vector<TaskSystem::Task<bool>> &blockers)
+    {
+        auto go = std::make_shared<std::atomic<bool>>(false);
+        for (uint32_t i = 0; i < mSystem->threadCount(); i++) {
+            blockers.push_back(mSystem->submit([go] {
+                while (!go->load()) {
+                    std::this_thread::yield();
+                }
+            }));
+        }
+        return go;
+    }
+
+protected:
+    std::unique_ptr<TaskSystem> mSystem;
+};
+
+template<typename T>
+void expectBrokenPromise(TaskSystem::Task<T> &task)
+{
+    try {
+        task.get();
+        ADD_FAILURE() << "task did not fail";
+    } catch (const std::future_error &e) {
+        EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+    }
+}
+
+}
+
+TEST_P(TaskSystemTest, ThenChain)
+{
+    auto task = mSystem->submit([] {
+        return 2;
+    }).then([](int v) {
+        return v * 3;
+    }).then([](int v) {
+        return std::to_string(v);
+    });
+    EXPECT_EQ(task.get(), "6");
+
+    auto voidTask = mSystem->submit([] {
+        return 1;
+    }).then([](int) {
+    });
+    EXPECT_TRUE(voidTask.get());
+}
+
+TEST_P(TaskSystemTest, ThenPropagatesError)
+{
+    std::atomic<bool> called{false};
+    auto task = mSystem->submit([]() -> int {
+        throw std::runtime_error("failed");
+    }).then([&called](int v) {
+        called = true;
+        return v + 1;
+    });
+    EXPECT_THROW(task.get(), std::runtime_error);
+    EXPECT_FALSE(called.load());
+}
+
+TEST_P(TaskSystemTest, ThenPropagatesCancel)
+{
+    std::vector<TaskSystem::Task<bool>> blockers;
+    auto go = block(blockers);
+
+    std::atomic<bool> called{false};
+    auto task = mSystem->submit([] {
+        return 1;
+    });
+    task.cancel();
+    auto next = task.then([&called](int) {
+        called = true;
+        return 2;
+    });
+    go->store(true);
+    expectBrokenPromise(next);
+    EXPECT_FALSE(called.load());
+    TaskSystem::whenAll(blockers).wait();
+}
+
+TEST_P(TaskSystemTest, WhenAll)
+{
+    std::vector<TaskSystem::Task<int>> tasks;
+    for (int i = 0; i < 50; i++) {
+        tasks.push_back(mSystem->submit([i] {
+            return i;
+        }));
+    }
+    EXPECT_TRUE(TaskSystem::whenAll(tasks).get());
+    int sum = 0;
+    for (auto &task: tasks) {
+        sum += task.get();
+    }
+    EXPECT_EQ(sum, 49 * 50 / 2);
+
+    std::vector<TaskSystem::Task<int>> empty;
+    EXPECT_TRUE(TaskSystem::whenAll(empty).get());
+}
+
+TEST_P(TaskSystemTest, WhenAllFails)
+{
+    std::vector<TaskSystem::Task<int>> tasks;
+    tasks.push_back(mSystem->submit([] {
+        return 1;
+    }));
+    tasks.push_back(mSystem->submit([]() -> int {
+        throw std::runtime_error("failed");
+    }));
+    auto all = TaskSystem::whenAll(tasks);
+    EXPECT_THROW(all.get(), std::runtime_error);
+    EXPECT_EQ(tasks[0].get(), 1);
+}
+
+TEST_P(TaskSystemTest, WhenAny)
+{
+    std::vector<TaskSystem::Task<int>> tasks;
+    tasks.push_back(mSystem->submit([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return 1;
+    }));
+    tasks.push_back(mSystem->submit([] {
+        return 2;
+    }));
+    EXPECT_LT(TaskSystem::whenAny(tasks).get(), tasks.size());
+    EXPECT_EQ(tasks[0].get(), 1);
+
+    std::vector<TaskSystem::Task<int>> empty;
+    auto none = TaskSystem::whenAny(empty);
+    expectBrokenPromise(none);
+}
+
+TEST_P(TaskSystemTest, WhenAnyFailedInput)
+{
+    // A failed task counts as completed, its error stays with the task
+    std::vector<TaskSystem::Task<int>> tasks;
+    tasks.push_back(mSystem->submit([]() -> int {
+        throw std::runtime_error("failed");
+    }));
+    EXPECT_EQ(TaskSystem::whenAny(tasks).get(), 0u);
+    EXPECT_THROW(tasks[0].get(), std::runtime_error);
+}
+
+TEST_P(TaskSystemTest, GraphOrder)
+{
+    for (int rep = 0; rep < 50; rep++) {
+        TaskGraph graph;
+        std::atomic<int> order{0};
+        int a = -1, b = -1, c = -1, d = -1;
+        const auto nodeA = graph.add([&] { a = order++; });
+        const auto nodeB = graph.add([&] { b = order++; });
+        const auto nodeC = graph.add([&] { c = order++; });
+        const auto nodeD = graph.add([&] { d = order++; });
+        graph.precede(nodeA, nodeB);
+        graph.precede(nodeA, nodeC);
+        graph.precede(nodeB, nodeD);
+        graph.precede(nodeC, nodeD);
+        ASSERT_TRUE(graph.run(*mSystem).get());
+        EXPECT_EQ(a, 0);
+        EXPECT_GT(b, 0);
+        EXPECT_GT(c, 0);
+        EXPECT_EQ(d, 3);
+    }
+}
+
+TEST_P(TaskSystemTest, GraphFanOut)
+{
+    TaskGraph graph;
+    std::atomic<int> count{0};
+    int seen = -1;
+    const auto root = graph.add([] {});
+    const auto sink = graph.add([&] { seen = count.load(); });
+    for (int i = 0; i < 1000; i++) {
+        const auto node = graph.add([&count] { count++; });
+        graph.precede(root, node);
+        graph.precede(node, sink);
+    }
+    EXPECT_TRUE(graph.run(*mSystem).get());
+    EXPECT_EQ(seen, 1000);
+
+    // A graph can be run again
+    EXPECT_TRUE(graph.run(*mSystem).get());
+    EXPECT_EQ(seen, 2000);
+}
+
+TEST_P(TaskSystemTest, GraphRejectsCycle)
+{
+    TaskGraph graph;
+    std::atomic<bool> ran{false};
+    const auto x = graph.add([&ran] { ran = true; });
+    const auto y = graph.add([&ran] { ran = true; });
+    graph.precede(x, y);
+    graph.precede(y, x);
+    auto run = graph.run(*mSystem);
+    EXPECT_THROW(run.get(), std::logic_error);
+    EXPECT_FALSE(ran.load());
+}
+
+TEST_P(TaskSystemTest, GraphNodeThrows)
+{
+    TaskGraph graph;
+    std::atomic<bool> ran{false};
+    const auto a = graph.add([] { throw std::runtime_error("node"); });
+    const auto b = graph.add([&ran] { ran = true; });
+    graph.precede(a, b);
+    auto run = graph.run(*mSystem);
+    EXPECT_THROW(run.get(), std::runtime_error);
+    EXPECT_FALSE(ran.load());
+}
+
+TEST_P(TaskSystemTest, StopAbandonsQueuedGraph)
+{
+    std::vector<TaskSystem::Task<bool>> blockers;
+    auto go = block(blockers);
+
+    TaskGraph graph;
+    std::atomic<bool> ran{false};
+    const auto a = graph.add([&ran] { ran = true; });
+    const auto b = graph.add([&ran] { ran = true; });
+    graph.precede(a, b);
+    auto run = graph.run(*mSystem);
+
+    std::thread release([go] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        go->store(true);
+    });
+    mSystem->stop();
+    release.join();
+    expectBrokenPromise(run);
+    EXPECT_FALSE(ran.load());
+}
+
+TEST_P(TaskSystemTest, NotRunningAbandonsQueued)
+{
+    TaskSystem system(2, "TestIdleTaskSystem", GetParam());
+    auto task = system.submit([] {
+        return 1;
+    });
+    auto next = system.submit([] {
+        return 2;
+    }).then([](int v) {
+        return v + 1;
+    });
+    system.stop();
+    expectBrokenPromise(task);
+    expectBrokenPromise(next);
+
+    // Submitted after stop(), abandoned when the system is destroyed
+    TaskSystem::Task<int> late;
+    {
+        TaskSystem stopped(2, "TestStoppedTaskSystem", GetParam());
+        stopped.start();
+        stopped.stop();
+        late = stopped.submit([] {
+            return 3;
+        });
+    }
+    expectBrokenPromise(late);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, TaskSystemTest,
+                         ::testing::Values(TaskSystem::SharedQueue, TaskSystem::WorkStealing));